@@ -0,0 +1,455 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "rules.h"
+#include "level.h"
+#include "bot.h"
+#include "advisor.h"
+
+/*!*****************************************************************************
+	\brief	Clamp a value between two limits
+
+	\date	19.10.26
+*******************************************************************************/
+static int clamp(int value, int low, int high) {
+	return (value < low)? low: (value > high)? high: value;
+}
+
+/*!*****************************************************************************
+	\brief	Find a random empty cell the way a teleport does
+
+	Gives up after a number of tries, which counts as a failed teleport.
+
+	\param	b
+		Board to look on
+
+	\param	x, y
+		The cell found
+
+	\param	state
+		State of the random generator
+
+	\return	0 if a cell was found, -1 if not
+
+	\date	19.10.26
+*******************************************************************************/
+static int randomEmpty(const struct board *b, int *x, int *y, unsigned long long *state) {
+	long long cell;
+	int tries;
+
+	for(tries=0; tries<64; tries++) {
+		cell = (long long)(nextBits(state) % ((unsigned long long)b->w * b->h));
+		if(b->cells[cell] == EMPTY) {
+			*x = (int)(cell % b->w);
+			*y = (int)(cell / b->w);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*!*****************************************************************************
+	\brief	Pick a move for the hero of a random game
+
+	Steps to a free cell furthest from the robots two cells around, picking
+	at random between equally good ones, and teleports when nothing is safe.
+
+	\param	b
+		Board of the game
+
+	\param	x, y
+		Position of the hero
+
+	\param	state
+		State of the random generator
+
+	\return	Keypad number of the move
+
+	\date	19.10.26
+*******************************************************************************/
+static int pickMove(const struct board *b, int x, int y, unsigned long long *state) {
+	int move, i, j, dx, dy, nx, ny, d, nearest, best = BOT_TELEPORT, bestDistance = 1, ties = 0;
+
+	for(move=0; move<ADVISOR_MOVES; move++) {
+		if(keypadStep(move, &dx, &dy)) {
+			continue;
+		}
+		nx = x + dx;
+		ny = y + dy;
+		if((nx < 0) || (ny < 0) || (nx >= b->w) || (ny >= b->h) || ((move != BOT_WAIT) && (CELL(b, nx, ny) != EMPTY))) {
+			continue;
+		}
+		nearest = 3;
+		for(j=clamp(ny - 2, 0, b->h - 1); j<=clamp(ny + 2, 0, b->h - 1); j++) {
+			for(i=clamp(nx - 2, 0, b->w - 1); i<=clamp(nx + 2, 0, b->w - 1); i++) {
+				if(CELL(b, i, j) == ROBOT) {
+					d = (abs(i - nx) > abs(j - ny))? abs(i - nx): abs(j - ny);
+					nearest = (d < nearest)? d: nearest;
+				}
+			}
+		}
+		if(nearest > bestDistance) {
+			best = move;
+			bestDistance = nearest;
+			ties = 1;
+		}
+		else if((nearest == bestDistance) && (best != BOT_TELEPORT) && !(nextBits(state) % (unsigned long long)++ties)) {
+			best = move;
+		}
+	}
+	return best;
+}
+
+/*!*****************************************************************************
+	\brief	Make a move of the hero in a random game
+
+	\param	b
+		Board of the game
+
+	\param	move
+		Keypad number of the move
+
+	\param	x, y
+		Position of the hero, changed by the move
+
+	\param	teleports
+		Safe teleports left
+
+	\param	state
+		State of the random generator
+
+	\return	-1 if the hero died, 1 after a safe teleport, 0 otherwise
+
+	\date	19.10.26
+*******************************************************************************/
+static int moveHero(struct board *b, int move, int *x, int *y, int *teleports, unsigned long long *state) {
+	int dx, dy, nx, ny, safe = 0;
+
+	if(keypadStep(move, &dx, &dy)) {
+		if(randomEmpty(b, &nx, &ny, state)) {
+			return -1;
+		}
+		if((safe = (*teleports > 0))) {
+			(*teleports)--;
+		}
+	}
+	else {
+		nx = clamp(*x + dx, 0, b->w - 1);
+		ny = clamp(*y + dy, 0, b->h - 1);
+		if(((nx != *x) || (ny != *y)) && (CELL(b, nx, ny) != EMPTY)) {
+			return -1;
+		}
+	}
+	setCell(b, *x, *y, EMPTY);
+	setCell(b, nx, ny, HERO);
+	*x = nx;
+	*y = ny;
+	return safe;
+}
+
+/*!*****************************************************************************
+	\brief	Play one random game and tell if the hero lived through it
+
+	The first move is made on the whole field, the rest of the game on a
+	window around the hero. The hero never gets near the edge of the
+	window, and robots further away cannot reach the hero in time.
+
+	\param	field
+		Field of the turn, not changed
+
+	\param	window
+		Board to play on, at most ADVISOR_WINDOW cells wide and high
+
+	\param	turn
+		Hero and seed of the turn
+
+	\param	move
+		Keypad number of the first move
+
+	\param	state
+		State of the random generator of this game
+
+	\return	1 if the hero is alive after ADVISOR_DEPTH turns, 0 if not
+
+	\date	19.10.26
+*******************************************************************************/
+static int rollout(const struct board *field, struct board *window, const struct advisorTurn *turn, int move, unsigned long long state) {
+	int x = turn->heroX, y = turn->heroY, teleports = turn->teleports;
+	int dx, dy, left, top, played, safe = 0, killed = 0;
+
+	if(keypadStep(move, &dx, &dy)) {
+		if(randomEmpty(field, &x, &y, &state)) {
+			return 0;
+		}
+		if((safe = (teleports > 0))) {
+			teleports--;
+		}
+	}
+	else {
+		x = clamp(x + dx, 0, field->w - 1);
+		y = clamp(y + dy, 0, field->h - 1);
+		if(((x != turn->heroX) || (y != turn->heroY)) && (CELL(field, x, y) != EMPTY)) {
+			return 0;
+		}
+	}
+	left = clamp(x - ADVISOR_REACH, 0, field->w - window->w);
+	top = clamp(y - ADVISOR_REACH, 0, field->h - window->h);
+	copyWindow(window, field, left, top);
+	if((turn->heroX >= left) && (turn->heroX < left + window->w) && (turn->heroY >= top) && (turn->heroY < top + window->h)) {
+		setCell(window, turn->heroX - left, turn->heroY - top, EMPTY);
+	}
+	x -= left;
+	y -= top;
+	setCell(window, x, y, HERO);
+	for(played=1; ; played++) {
+		if(!safe && stepRobots(window, x, y, &killed)) {
+			return 0;
+		}
+		if(played == ADVISOR_DEPTH) {
+			return 1;
+		}
+		if((safe = moveHero(window, pickMove(window, x, y, &state), &x, &y, &teleports, &state)) < 0) {
+			return 0;
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Play a batch of random games for every move
+
+	Each game has a seed of its own, so the odds never depend on how the
+	games were split in batches.
+
+	\param	a
+		Advisor handler
+
+	\param	field
+		Field of the turn
+
+	\param	turn
+		Hero and seed of the turn
+
+	\param	first, count
+		Index of the first game of the batch and games per move
+
+	\param	generation
+		Request the games are for, a newer request cancels them
+
+	\param	advice
+		Games played and survived, added to
+
+	\return	0 on success, -1 if cancelled
+
+	\date	19.10.26
+*******************************************************************************/
+static int playRollouts(struct advisor *a, const struct board *field, const struct advisorTurn *turn, int first, int count, unsigned int generation, struct advice *advice) {
+	int move, i;
+
+	for(move=0; move<ADVISOR_MOVES; move++) {
+		if(__atomic_load_n(&a->generation, __ATOMIC_RELAXED) != generation) {
+			return -1;
+		}
+		for(i=first; i<first + count; i++) {
+			advice->survived[move] += rollout(field, &a->window, turn, move,
+				turn->seed ^ (((unsigned long long)i * ADVISOR_MOVES + move + 1) * 0xD1B54A32D192ED03ULL));
+		}
+	}
+	advice->rollouts += count;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Advisor thread, plays games for the latest request until it has
+		ADVISOR_ROLLOUTS of them
+
+	\param	data
+		Advisor handler
+
+	\date	19.10.26
+*******************************************************************************/
+static int advisorWorker(void *data) {
+	struct advisor *a = (struct advisor *)data;
+	struct advisorTurn turn;
+	struct advice batch;
+	unsigned int generation = a->generation - 1;
+	int i, first;
+
+	SDL_LockMutex(a->lock);
+	while(!a->quit) {
+		if(!a->active || (a->advice.rollouts >= ADVISOR_ROLLOUTS)) {
+			SDL_CondWait(a->wake, a->lock);
+			continue;
+		}
+		// The request board is only ever copied over, so it can be swapped
+		if(generation != a->generation) {
+			generation = a->generation;
+			swapBoards(&a->request, &a->field);
+			turn = a->turn;
+		}
+		first = a->advice.rollouts;
+		SDL_UnlockMutex(a->lock);
+		memset(&batch, 0, sizeof(batch));
+		i = playRollouts(a, &a->field, &turn, first, ADVISOR_BATCH, generation, &batch);
+		SDL_LockMutex(a->lock);
+		if(!i && (generation == a->generation)) {
+			a->advice.rollouts += batch.rollouts;
+			for(i=0; i<ADVISOR_MOVES; i++) {
+				a->advice.survived[i] += batch.survived[i];
+			}
+		}
+	}
+	SDL_UnlockMutex(a->lock);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Start the advisor for a field size
+
+	Without a thread, the games are played when a turn is posted, so they
+	are the same on every run.
+
+	\param	a
+		Advisor handler
+
+	\param	w, h
+		Size of the field
+
+	\param	threaded
+		1 to play the games on a thread of their own
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int startAdvisor(struct advisor *a, int w, int h, int threaded) {
+	memset(a, 0, sizeof(*a));
+	if(createBoard(&a->window, (w < ADVISOR_WINDOW)? w: ADVISOR_WINDOW, (h < ADVISOR_WINDOW)? h: ADVISOR_WINDOW)) {
+		return -1;
+	}
+	if(!threaded) {
+		return 0;
+	}
+	if(createBoard(&a->request, w, h) || createBoard(&a->field, w, h)) {
+		stopAdvisor(a);
+		return -1;
+	}
+	a->lock = SDL_CreateMutex();
+	a->wake = SDL_CreateCond();
+	if((a->lock != NULL) && (a->wake != NULL)) {
+		a->thread = SDL_CreateThread(advisorWorker, a);
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Post a new turn, the games of the turn before are cancelled
+
+	\param	a
+		Advisor handler
+
+	\param	b
+		Playfield of the turn
+
+	\param	heroX, heroY
+		Position of the hero
+
+	\param	teleports
+		Safe teleports left
+
+	\param	seed
+		Seed of the random games
+
+	\date	19.10.26
+*******************************************************************************/
+void adviseOn(struct advisor *a, const struct board *b, int heroX, int heroY, int teleports, unsigned long long seed) {
+	struct advisorTurn turn = { heroX, heroY, teleports, seed };
+
+	if(a->thread == NULL) {
+		memset(&a->advice, 0, sizeof(a->advice));
+		playRollouts(a, b, &turn, 0, ADVISOR_INLINE, a->generation, &a->advice);
+		return;
+	}
+	SDL_LockMutex(a->lock);
+	copyBoard(&a->request, b);
+	a->turn = turn;
+	__atomic_store_n(&a->generation, a->generation + 1, __ATOMIC_RELAXED);
+	a->active = 1;
+	memset(&a->advice, 0, sizeof(a->advice));
+	SDL_CondSignal(a->wake);
+	SDL_UnlockMutex(a->lock);
+}
+
+/*!*****************************************************************************
+	\brief	Cancel the games, when no turn is being played
+
+	\param	a
+		Advisor handler
+
+	\date	19.10.26
+*******************************************************************************/
+void stopAdvising(struct advisor *a) {
+	if(a->thread == NULL) {
+		memset(&a->advice, 0, sizeof(a->advice));
+		return;
+	}
+	SDL_LockMutex(a->lock);
+	__atomic_store_n(&a->generation, a->generation + 1, __ATOMIC_RELAXED);
+	a->active = 0;
+	memset(&a->advice, 0, sizeof(a->advice));
+	SDL_UnlockMutex(a->lock);
+}
+
+/*!*****************************************************************************
+	\brief	Get the odds counted so far for the latest turn
+
+	\param	a
+		Advisor handler
+
+	\param	advice
+		Copy of the odds
+
+	\date	19.10.26
+*******************************************************************************/
+void takeAdvice(struct advisor *a, struct advice *advice) {
+	if(a->thread == NULL) {
+		*advice = a->advice;
+		return;
+	}
+	SDL_LockMutex(a->lock);
+	*advice = a->advice;
+	SDL_UnlockMutex(a->lock);
+}
+
+/*!*****************************************************************************
+	\brief	Stop the advisor thread and free its boards
+
+	\param	a
+		Advisor handler
+
+	\date	19.10.26
+*******************************************************************************/
+void stopAdvisor(struct advisor *a) {
+	if(a->thread != NULL) {
+		SDL_LockMutex(a->lock);
+		a->quit = 1;
+		__atomic_store_n(&a->generation, a->generation + 1, __ATOMIC_RELAXED);
+		SDL_CondSignal(a->wake);
+		SDL_UnlockMutex(a->lock);
+		SDL_WaitThread(a->thread, NULL);
+		a->thread = NULL;
+	}
+	if(a->wake != NULL) {
+		SDL_DestroyCond(a->wake);
+	}
+	if(a->lock != NULL) {
+		SDL_DestroyMutex(a->lock);
+	}
+	freeBoard(&a->request);
+	freeBoard(&a->field);
+	freeBoard(&a->window);
+	memset(a, 0, sizeof(*a));
+}
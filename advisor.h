@@ -0,0 +1,69 @@
+#ifndef ADVISOR_H
+#define ADVISOR_H
+
+#include "sdl.h"
+#include "board.h"
+#include "bot.h"
+
+#define ADVISOR_DEPTH 8
+#define ADVISOR_REACH (2 * ADVISOR_DEPTH + 1)
+#define ADVISOR_WINDOW (2 * ADVISOR_REACH + 1)
+#define ADVISOR_BATCH 16
+#define ADVISOR_ROLLOUTS 4096
+#define ADVISOR_INLINE 32
+#define ADVISOR_POLL 100
+#define ADVISOR_MOVES BOT_MOVES
+
+/*!*****************************************************************************
+	\brief	Survival odds of each move, counted from random games
+
+	Moves are indexed by their keypad key as in keypadStep.
+	Every move has been tried rollouts times.
+
+	\date	19.10.26
+*******************************************************************************/
+struct advice {
+	int rollouts;
+	int survived[ADVISOR_MOVES];
+};
+
+/*!*****************************************************************************
+	\brief	Turn the random games start from, besides the field
+
+	\date	19.10.26
+*******************************************************************************/
+struct advisorTurn {
+	int heroX, heroY;
+	int teleports;
+	unsigned long long seed;
+};
+
+/*!*****************************************************************************
+	\brief	Worker thread playing random games from the latest turn
+
+	The logic thread posts each turn as a request, which cancels the games
+	of the turn before. Without a thread the games are played when posted.
+
+	\date	19.10.26
+*******************************************************************************/
+struct advisor {
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	int quit;
+	int active;
+	unsigned int generation;
+	struct board request;
+	struct advisorTurn turn;
+	struct advice advice;
+	struct board field;
+	struct board window;
+};
+
+int startAdvisor(struct advisor *a, int w, int h, int threaded);
+void adviseOn(struct advisor *a, const struct board *b, int heroX, int heroY, int teleports, unsigned long long seed);
+void stopAdvising(struct advisor *a);
+void takeAdvice(struct advisor *a, struct advice *advice);
+void stopAdvisor(struct advisor *a);
+
+#endif
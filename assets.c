@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sdl.h"
+#include "assets.h"
+
+extern const unsigned char assetBlob[];
+extern const unsigned char assetBlobEnd[];
+
+static const unsigned char *blob;
+static size_t blobSize;
+static void *mapped;
+
+/*!*****************************************************************************
+	\brief	Take an asset blob into use
+
+	Sprites and the font are used straight from the blob, so it stays open
+	until the game quits.
+
+	\param	path
+		Blob file to map to memory, NULL for the blob linked in the game
+
+	\return	0 on success, -1 if the blob is missing or broken
+
+	\date	19.10.26
+*******************************************************************************/
+int openAssets(const char *path) {
+	const struct assetHeader *header;
+	const struct assetEntry *entry;
+	struct stat info;
+	uint32_t i;
+	int fd;
+
+	if(path == NULL) {
+		blob = assetBlob;
+		blobSize = (size_t)(assetBlobEnd - assetBlob);
+	}
+	else {
+		if((fd = open(path, O_RDONLY)) < 0) {
+			perror(path);
+			return -1;
+		}
+		if(fstat(fd, &info) || (info.st_size < (off_t)sizeof(*header)) ||
+			((mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)) {
+			fprintf(stderr, "Couldn't map %s\n", path);
+			mapped = NULL;
+			close(fd);
+			return -1;
+		}
+		close(fd);
+		blob = mapped;
+		blobSize = (size_t)info.st_size;
+	}
+
+	header = (const struct assetHeader *)blob;
+	if((blobSize < sizeof(*header)) || (header->magic != ASSET_MAGIC) || (header->version != ASSET_VERSION) ||
+		(header->size > blobSize) || (sizeof(*header) + (size_t)header->count * sizeof(*entry) > blobSize)) {
+		fprintf(stderr, "Asset blob %s is not for this game\n", (path != NULL)? path: "in the game");
+		closeAssets();
+		return -1;
+	}
+	for(i=0; i<header->count; i++) {
+		entry = (const struct assetEntry *)(header + 1) + i;
+		if(((size_t)entry->offset + entry->size > blobSize) || (entry->bpp && ((size_t)entry->pitch * entry->h > entry->size))) {
+			fprintf(stderr, "Asset %.*s is broken\n", ASSET_NAME, entry->name);
+			closeAssets();
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Find an asset by its name
+
+	\return	Entry of the asset or NULL if there is none
+
+	\date	19.10.26
+*******************************************************************************/
+const struct assetEntry *findAsset(const char *name) {
+	const struct assetHeader *header = (const struct assetHeader *)blob;
+	const struct assetEntry *entry;
+	uint32_t i;
+
+	if(blob == NULL) {
+		return NULL;
+	}
+	for(i=0; i<header->count; i++) {
+		entry = (const struct assetEntry *)(header + 1) + i;
+		if(!strncmp(entry->name, name, ASSET_NAME)) {
+			return entry;
+		}
+	}
+	fprintf(stderr, "No asset %s\n", name);
+	return NULL;
+}
+
+/*!*****************************************************************************
+	\brief	Make a surface of an image asset without copying its pixels
+
+	The surface must only be read from, the pixels may be in read-only
+	memory.
+
+	\param	name
+		Name of the image
+
+	\return	Surface or NULL on failure
+
+	\date	19.10.26
+*******************************************************************************/
+SDL_Surface *loadSprite(const char *name) {
+	const struct assetEntry *entry;
+
+	if(((entry = findAsset(name)) == NULL) || !entry->bpp) {
+		return NULL;
+	}
+	return SDL_CreateRGBSurfaceFrom((void *)(blob + entry->offset), entry->w, entry->h, entry->bpp, entry->pitch,
+		entry->rmask, entry->gmask, entry->bmask, 0);
+}
+
+/*!*****************************************************************************
+	\brief	Open a font asset
+
+	\param	name
+		Name of the font
+
+	\param	size
+		Point size of the font
+
+	\return	Font or NULL on failure
+
+	\date	19.10.26
+*******************************************************************************/
+TTF_Font *loadFont(const char *name, int size) {
+	const struct assetEntry *entry;
+	SDL_RWops *rw;
+
+	if(((entry = findAsset(name)) == NULL) || ((rw = SDL_RWFromConstMem(blob + entry->offset, (int)entry->size)) == NULL)) {
+		return NULL;
+	}
+	return TTF_OpenFontRW(rw, 1, size);
+}
+
+/*!*****************************************************************************
+	\brief	Stop using the asset blob, after all sprites and fonts are freed
+
+	\date	19.10.26
+*******************************************************************************/
+void closeAssets(void) {
+	if(mapped != NULL) {
+		munmap(mapped, blobSize);
+	}
+	mapped = NULL;
+	blob = NULL;
+	blobSize = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <stdint.h>
+
+#define ASSET_MAGIC	0x41544252
+#define ASSET_VERSION	1
+#define ASSET_NAME	16
+#define ASSET_ALIGN	16
+
+/*!*****************************************************************************
+	\brief	Start of an asset blob, followed by count entries
+
+	\date	19.10.26
+*******************************************************************************/
+struct assetHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t size;
+};
+
+/*!*****************************************************************************
+	\brief	One image or file in an asset blob
+
+	Images are stored ready for drawing, bpp bits per pixel with the given
+	colour masks. Other files have bpp 0 and are stored as they are.
+
+	\date	19.10.26
+*******************************************************************************/
+struct assetEntry {
+	char name[ASSET_NAME];
+	uint32_t offset;
+	uint32_t size;
+	uint16_t w, h;
+	uint16_t pitch, bpp;
+	uint32_t rmask, gmask, bmask;
+	uint32_t unused;
+};
+
+#ifndef ASSET_PACKER
+#include "sdl.h"
+
+int openAssets(const char *path);
+const struct assetEntry *findAsset(const char *name);
+SDL_Surface *loadSprite(const char *name);
+TTF_Font *loadFont(const char *name, int size);
+void closeAssets(void);
+#endif
+
+#endif
@@ -0,0 +1,295 @@
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "pipeline.h"
+#include "pool.h"
+#include "camera.h"
+#include "bands.h"
+#include "render.h"
+#include "scale.h"
+
+/*!*****************************************************************************
+	\brief	Work shared by all bands of one frame
+
+	\date	19.10.26
+*******************************************************************************/
+struct bandWork {
+	const struct frame *f;
+	const struct spriteSet *set;
+	int rows;
+	Uint32 background;
+};
+
+static struct pool *bandPool;
+
+/*!*****************************************************************************
+	\brief	Start the threads drawing the bands
+
+	\return	0 on success, -1 if the frames will be drawn on a single thread
+
+	\date	19.10.26
+*******************************************************************************/
+int initBands(void) {
+	if((bandPool = createPool(cpuCount() - 1)) == NULL) {
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Fill rows of the screen with one colour
+
+	\param	top, bottom
+		First row and the row after the last one to fill
+
+	\param	colour
+		Colour in the screen pixel format
+
+	\date	19.10.26
+*******************************************************************************/
+static void fillRows(int top, int bottom, Uint32 colour) {
+	Uint8 *row = (Uint8 *)screen->pixels + top * screen->pitch;
+	int x, y;
+
+	if(top >= bottom) {
+		return;
+	}
+	for(x=0; x<screen->w; x++) {
+		if(screen->format->BytesPerPixel == 2) {
+			((Uint16 *)row)[x] = (Uint16)colour;
+		}
+		else {
+			((Uint32 *)row)[x] = colour;
+		}
+	}
+	for(y=top+1; y<bottom; y++) {
+		memcpy(row + (y - top) * screen->pitch, row, screen->w * screen->format->BytesPerPixel);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Copy the part of a sprite that falls between two screen rows
+
+	Sprites come from a set already scaled to the cell size, so every row is
+	a plain copy.
+
+	\param	sprite
+		Scaled sprite sheet in the screen pixel format
+
+	\param	src
+		Sprite rectangle on the scaled sheet
+
+	\param	x, y
+		Position of the cell on the field
+
+	\param	top, bottom
+		Rows of the screen the band owns
+
+	\date	19.10.26
+*******************************************************************************/
+static void copySprite(SDL_Surface *sprite, SDL_Rect *src, int x, int y, int top, int bottom) {
+	int bpp = screen->format->BytesPerPixel;
+	int left = x * src->w - camera.x, first = y * src->h - camera.y;
+	int right = left + src->w, row, col;
+
+	right = (right > screen->w)? screen->w: right;
+	bottom = (first + src->h < bottom)? first + src->h: bottom;
+	row = (first < top)? top: first;
+	col = (left < 0)? 0: left;
+	if(col >= right) {
+		return;
+	}
+	for(; row<bottom; row++) {
+		memcpy((Uint8 *)screen->pixels + row * screen->pitch + col * bpp,
+			(Uint8 *)sprite->pixels + (src->y + row - first) * sprite->pitch + (src->x + col - left) * bpp, (right - col) * bpp);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Draw the sprite of one cell between two screen rows
+
+	\param	f
+		Frame being drawn
+
+	\param	set
+		Sprites scaled to the cell size of the camera
+
+	\param	x, y
+		Position of the cell on the field
+
+	\param	top, bottom
+		Rows of the screen that may be written
+
+	\date	19.10.26
+*******************************************************************************/
+static void drawCell(const struct frame *f, const struct spriteSet *set, int x, int y, int top, int bottom) {
+	SDL_Rect src;
+	int item;
+
+	switch(item = CELL(&f->playfield, x, y)) {
+		case HERO_EXPLOSION:
+		case EXPLOSION:
+		case TRASH:
+			initRectangle(&src, ((item == HERO_EXPLOSION)? 2: (item == EXPLOSION)? 1: 0) * set->cell, 0, set->cell, set->cell);
+			copySprite(set->sheet[SHEET_TRASH], &src, x, y, top, bottom);
+		break;
+		case ROBOT:
+			if(!getRobotImage(&src, getDirection(f, x, y))) {
+				spriteRect(&src, set->cell);
+				copySprite(set->sheet[SHEET_ROBOT], &src, x, y, top, bottom);
+			}
+		break;
+		case HERO:
+			if(!getHeroImage(&src, f->heroImage)) {
+				spriteRect(&src, set->cell);
+				copySprite(set->sheet[SHEET_HERO], &src, x, y, top, bottom);
+			}
+		break;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Draw all cells touching one horizontal band of the screen
+
+	Writes only the rows of its own band, so bands can be drawn at the same
+	time. Chunks without anything in them are skipped.
+
+	\param	data
+		Work of the frame
+
+	\param	band
+		Index of the band from the top of the screen
+
+	\date	19.10.26
+*******************************************************************************/
+static void drawBand(void *data, int band) {
+	struct bandWork *work = (struct bandWork *)data;
+	const struct frame *f = work->f;
+	const struct board *b = &f->playfield;
+	int top = band * work->rows, bottom = top + work->rows;
+	int x, y, x0, y0, x1, y1, cx, cy;
+
+	bottom = (bottom > screen->h)? screen->h: bottom;
+	fillRows(top, bottom, work->background);
+	if(visibleCells(&camera, b, top, bottom, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	for(cy=y0 >> CHUNK_SHIFT; cy<=(y1 >> CHUNK_SHIFT); cy++) {
+		for(cx=x0 >> CHUNK_SHIFT; cx<=(x1 >> CHUNK_SHIFT); cx++) {
+			if(!CHUNK(b, cx, cy)) {
+				continue;
+			}
+			for(y=((cy << CHUNK_SHIFT) > y0)? (cy << CHUNK_SHIFT): y0; (y <= y1) && (y < ((cy + 1) << CHUNK_SHIFT)); y++) {
+				for(x=((cx << CHUNK_SHIFT) > x0)? (cx << CHUNK_SHIFT): x0; (x <= x1) && (x < ((cx + 1) << CHUNK_SHIFT)); x++) {
+					drawCell(f, work->set, x, y, top, bottom);
+				}
+			}
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Clear one cell on the screen and draw it again
+
+	The screen has to be locked by the caller if it needs locking.
+
+	\param	f
+		Frame being drawn
+
+	\param	x, y
+		Position of the cell on the field
+
+	\date	19.10.26
+*******************************************************************************/
+void redrawCell(const struct frame *f, int x, int y) {
+	const struct spriteSet *set = spriteSet(camera.cell);
+	Uint32 background = SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF);
+	int left = x * camera.cell - camera.x, first = y * camera.cell - camera.y;
+	int right = left + camera.cell, bottom = first + camera.cell, row, col;
+	Uint8 *line;
+
+	left = (left < 0)? 0: left;
+	first = (first < 0)? 0: first;
+	right = (right > screen->w)? screen->w: right;
+	bottom = (bottom > screen->h)? screen->h: bottom;
+	for(row=first; row<bottom; row++) {
+		line = (Uint8 *)screen->pixels + row * screen->pitch;
+		for(col=left; col<right; col++) {
+			if(screen->format->BytesPerPixel == 2) {
+				((Uint16 *)line)[col] = (Uint16)background;
+			}
+			else {
+				((Uint32 *)line)[col] = background;
+			}
+		}
+	}
+	if(set != NULL) {
+		drawCell(f, set, x, y, 0, screen->h);
+	}
+	drawDanger(f, x, y);
+}
+
+/*!*****************************************************************************
+	\brief	Check if the renderer shows the screen pixels, and the screen and
+		sprites are in a format bands can draw
+
+	\date	19.10.26
+*******************************************************************************/
+int bandsAvailable(void) {
+	int bpp = screen->format->BytesPerPixel;
+
+	if(!renderer->direct || ((bpp != 2) && (bpp != 4))) {
+		return 0;
+	}
+	return (robot->format->BytesPerPixel == bpp) && (hero->format->BytesPerPixel == bpp) && (trash->format->BytesPerPixel == bpp);
+}
+
+/*!*****************************************************************************
+	\brief	Draw the field of a frame in horizontal bands on all cores
+
+	\param	f
+		Frame to be drawn
+
+	\return	0 on success, -1 if the caller has to draw the frame itself
+
+	\date	19.10.26
+*******************************************************************************/
+int drawBands(const struct frame *f) {
+	struct bandWork work;
+	int band, bands;
+
+	if(!bandsAvailable() || ((work.set = spriteSet(camera.cell)) == NULL)) {
+		return -1;
+	}
+	bands = ((bandPool != NULL)? bandPool->threads + 1: 1) * BANDS_PER_THREAD;
+	work.f = f;
+	work.rows = (screen->h + bands - 1) / bands;
+	work.background = SDL_MapRGB(screen->format, 0xFF, 0xFF, 0xFF);
+	if(SDL_MUSTLOCK(screen) && (SDL_LockSurface(screen) < 0)) {
+		return -1;
+	}
+	if(bandPool != NULL) {
+		runPool(bandPool, bands, drawBand, &work);
+	}
+	else {
+		for(band=0; band<bands; band++) {
+			drawBand(&work, band);
+		}
+	}
+	if(SDL_MUSTLOCK(screen)) {
+		SDL_UnlockSurface(screen);
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Stop the band drawing threads
+
+	\date	19.10.26
+*******************************************************************************/
+void freeBands(void) {
+	freeSpriteSets();
+	destroyPool(bandPool);
+	bandPool = NULL;
+}
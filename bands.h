@@ -0,0 +1,14 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+#include "pipeline.h"
+
+#define BANDS_PER_THREAD 4
+
+int initBands(void);
+int bandsAvailable(void);
+int drawBands(const struct frame *f);
+void redrawCell(const struct frame *f, int x, int y);
+void freeBands(void);
+
+#endif
@@ -0,0 +1,229 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+
+/*!*****************************************************************************
+	\brief	Reserve an empty board
+
+	\param	b
+		Board handler
+
+	\param	w, h
+		Size of the board in cells
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int createBoard(struct board *b, int w, int h) {
+	b->journal = NULL;
+	b->w = w;
+	b->h = h;
+	b->chunksX = (w + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+	b->chunksY = (h + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+	b->cells = calloc((size_t)w * h, 1);
+	b->occupied = calloc((size_t)b->chunksX * b->chunksY, sizeof(*b->occupied));
+	if((b->cells == NULL) || (b->occupied == NULL)) {
+		freeBoard(b);
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Free the memory of a board
+
+	\param	b
+		Board handler
+
+	\date	19.10.26
+*******************************************************************************/
+void freeBoard(struct board *b) {
+	free(b->cells);
+	free(b->occupied);
+	b->cells = NULL;
+	b->occupied = NULL;
+}
+
+/*!*****************************************************************************
+	\brief	Empty all cells of a board
+
+	\param	b
+		Board handler
+
+	\date	19.10.26
+*******************************************************************************/
+void clearBoard(struct board *b) {
+	if(b->journal != NULL) {
+		resetJournal(b->journal);
+	}
+	memset(b->cells, 0, (size_t)b->w * b->h);
+	memset(b->occupied, 0, (size_t)b->chunksX * b->chunksY * sizeof(*b->occupied));
+}
+
+/*!*****************************************************************************
+	\brief	Copy the cells of a board to another board of the same size
+
+	\param	dst
+		Board to copy to
+
+	\param	src
+		Board to copy from
+
+	\date	19.10.26
+*******************************************************************************/
+void copyBoard(struct board *dst, const struct board *src) {
+	if(dst->journal != NULL) {
+		resetJournal(dst->journal);
+	}
+	memcpy(dst->cells, src->cells, (size_t)src->w * src->h);
+	memcpy(dst->occupied, src->occupied, (size_t)src->chunksX * src->chunksY * sizeof(*src->occupied));
+}
+
+/*!*****************************************************************************
+	\brief	Copy a part of a bigger board to a board of its own
+
+	\param	dst
+		Board to copy to, its size is the size of the part
+
+	\param	src
+		Board to copy from
+
+	\param	x, y
+		Top left cell of the part on src, the part has to fit on src
+
+	\date	19.10.26
+*******************************************************************************/
+void copyWindow(struct board *dst, const struct board *src, int x, int y) {
+	int row, col;
+
+	if(dst->journal != NULL) {
+		resetJournal(dst->journal);
+	}
+	memset(dst->occupied, 0, (size_t)dst->chunksX * dst->chunksY * sizeof(*dst->occupied));
+	for(row=0; row<dst->h; row++) {
+		memcpy(&CELL(dst, 0, row), &CELL(src, x, y + row), dst->w);
+		for(col=0; col<dst->w; col++) {
+			CHUNK(dst, col >> CHUNK_SHIFT, row >> CHUNK_SHIFT) += (CELL(dst, col, row) != 0);
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Set every cell of the board to the same item
+
+	\param	b
+		Board handler
+
+	\param	item
+		enum robots value for all cells
+
+	\date	19.10.26
+*******************************************************************************/
+void fillBoard(struct board *b, char item) {
+	int cx, cy, cw, ch;
+
+	if(b->journal != NULL) {
+		resetJournal(b->journal);
+	}
+	memset(b->cells, item, (size_t)b->w * b->h);
+	for(cy=0; cy<b->chunksY; cy++) {
+		ch = (cy < b->chunksY - 1)? CHUNK_SIZE: b->h - cy * CHUNK_SIZE;
+		for(cx=0; cx<b->chunksX; cx++) {
+			cw = (cx < b->chunksX - 1)? CHUNK_SIZE: b->w - cx * CHUNK_SIZE;
+			CHUNK(b, cx, cy) = (item != 0)? cw * ch: 0;
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Swap the cells of two boards of the same size
+
+	Each board keeps its own journal.
+
+	\date	19.10.26
+*******************************************************************************/
+void swapBoards(struct board *a, struct board *b) {
+	char *cells = a->cells;
+	unsigned short *occupied = a->occupied;
+
+	a->cells = b->cells;
+	a->occupied = b->occupied;
+	b->cells = cells;
+	b->occupied = occupied;
+	if(a->journal != NULL) {
+		resetJournal(a->journal);
+	}
+	if(b->journal != NULL) {
+		resetJournal(b->journal);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Add a change to the journal of a board
+
+	If the list cannot grow, the journal is reset instead.
+
+	\param	j
+		Journal handler
+
+	\param	index
+		Index of the cell in the cells of the board
+
+	\param	before
+		Value of the cell before the change
+
+	\date	19.10.26
+*******************************************************************************/
+void logChange(struct journal *j, int index, char before) {
+	struct cellChange *grown;
+	int size;
+
+	j->serial++;
+	if(j->reset) {
+		return;
+	}
+	if(j->count == j->size) {
+		size = j->size? j->size * 2: 256;
+		if((grown = realloc(j->changes, size * sizeof(*j->changes))) == NULL) {
+			resetJournal(j);
+			return;
+		}
+		j->changes = grown;
+		j->size = size;
+	}
+	j->changes[j->count].index = index;
+	j->changes[j->count].before = before;
+	j->count++;
+}
+
+/*!*****************************************************************************
+	\brief	Tell the users of a journal to look at the whole board again
+
+	\date	19.10.26
+*******************************************************************************/
+void resetJournal(struct journal *j) {
+	j->serial++;
+	j->reset = 1;
+}
+
+/*!*****************************************************************************
+	\brief	Forget the changes in a journal
+
+	\date	19.10.26
+*******************************************************************************/
+void clearJournal(struct journal *j) {
+	j->count = 0;
+	j->reset = 0;
+}
+
+/*!*****************************************************************************
+	\brief	Free the memory of a journal
+
+	\date	19.10.26
+*******************************************************************************/
+void freeJournal(struct journal *j) {
+	free(j->changes);
+	memset(j, 0, sizeof(*j));
+}
@@ -0,0 +1,83 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#define CHUNK_SHIFT 4
+#define CHUNK_SIZE (1 << CHUNK_SHIFT)
+
+/*!*****************************************************************************
+	\brief	List of cells changed with setCell since the list was cleared
+
+	Changes that replace the whole board, such as clearing it, only set
+	reset, and the users of the list look at the whole board again. The
+	serial grows with every change and is never cleared.
+
+	\date	19.10.26
+*******************************************************************************/
+struct journal {
+	struct cellChange {
+		int index;
+		char before;
+	} *changes;
+	int count;
+	int size;
+	int reset;
+	unsigned int serial;
+};
+
+/*!*****************************************************************************
+	\brief	Playfield of any size, split in chunks of CHUNK_SIZE x CHUNK_SIZE
+
+	Cells are stored row by row. Every chunk keeps count of its non-empty
+	cells, so empty parts of a big field can be skipped without looking at
+	the cells.
+
+	\date	19.10.26
+*******************************************************************************/
+struct board {
+	int w, h;
+	int chunksX, chunksY;
+	char *cells;
+	unsigned short *occupied;
+	struct journal *journal;
+};
+
+#define CELL(b, x, y)	((b)->cells[(y) * (b)->w + (x)])
+#define CHUNK(b, cx, cy)	((b)->occupied[(cy) * (b)->chunksX + (cx)])
+
+void logChange(struct journal *j, int index, char before);
+
+/*!*****************************************************************************
+	\brief	Change one cell of the board and keep the chunk count up to date
+
+	\param	b
+		Board handler
+
+	\param	x, y
+		Position of the cell
+
+	\param	item
+		New enum robots value of the cell
+
+	\date	19.10.26
+*******************************************************************************/
+static inline void setCell(struct board *b, int x, int y, char item) {
+	char *cell = &CELL(b, x, y);
+	if(b->journal != NULL) {
+		logChange(b->journal, (int)(cell - b->cells), *cell);
+	}
+	CHUNK(b, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT) += (item != 0) - (*cell != 0);
+	*cell = item;
+}
+
+int createBoard(struct board *b, int w, int h);
+void freeBoard(struct board *b);
+void clearBoard(struct board *b);
+void copyBoard(struct board *dst, const struct board *src);
+void copyWindow(struct board *dst, const struct board *src, int x, int y);
+void fillBoard(struct board *b, char item);
+void swapBoards(struct board *a, struct board *b);
+void resetJournal(struct journal *j);
+void clearJournal(struct journal *j);
+void freeJournal(struct journal *j);
+
+#endif
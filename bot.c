@@ -0,0 +1,90 @@
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "danger.h"
+#include "bot.h"
+
+/*!*****************************************************************************
+	\brief	Keypad keys the bot can press, by the number of the move
+
+	\date	19.10.26
+*******************************************************************************/
+static const SDLKey botKeys[BOT_MOVES] = {
+	SDLK_KP0, SDLK_KP1, SDLK_KP2, SDLK_KP3, SDLK_KP4,
+	SDLK_KP5, SDLK_KP6, SDLK_KP7, SDLK_KP8, SDLK_KP9,
+};
+
+/*!*****************************************************************************
+	\brief	Pick the next key for a simple bot player
+
+	Waits while it is safe, so the robots crash into each other. Otherwise
+	steps to the free cell furthest from the robots, or teleports when no
+	step is safe. Robots further than BOT_SIGHT moves away are not counted.
+
+	\param	d
+		Danger map of the playfield
+
+	\param	b
+		Playfield
+
+	\param	heroX, heroY
+		Position of the hero
+
+	\date	19.10.26
+*******************************************************************************/
+SDLKey botMove(const struct dangerMap *d, const struct board *b, int heroX, int heroY) {
+	int i, move, dx, dy, x, y, distance, best = BOT_TELEPORT, bestDistance = 1;
+
+	// Waiting is looked at first, in place of the teleport
+	for(i=0; i<BOT_MOVES; i++) {
+		if(i == BOT_WAIT) {
+			continue;
+		}
+		move = i? i: BOT_WAIT;
+		keypadStep(move, &dx, &dy);
+		x = heroX + dx;
+		y = heroY + dy;
+		if((x < 0) || (y < 0) || (x >= b->w) || (y >= b->h)) {
+			continue;
+		}
+		if((move != BOT_WAIT) && (CELL(b, x, y) != EMPTY)) {
+			continue;
+		}
+		// A robot next to the cell would step on the hero
+		if((distance = dangerAt(d, x, y)) > BOT_SIGHT) {
+			distance = BOT_SIGHT + 1;
+		}
+		if(distance > bestDistance) {
+			if(move == BOT_WAIT) {
+				return botKeys[move];
+			}
+			best = move;
+			bestDistance = distance;
+		}
+	}
+	return botKeys[best];
+}
+
+/*!*****************************************************************************
+	\brief	Tell where a key of the bot moves the hero
+
+	\param	key
+		Key from botMove
+
+	\param	dx, dy
+		Step of the hero
+
+	\return	0 for a step, 1 for the teleport
+
+	\date	19.10.26
+*******************************************************************************/
+int botStep(SDLKey key, int *dx, int *dy) {
+	int move;
+
+	for(move=0; move<BOT_MOVES; move++) {
+		if(botKeys[move] == key) {
+			return keypadStep(move, dx, dy);
+		}
+	}
+	return keypadStep(BOT_TELEPORT, dx, dy);
+}
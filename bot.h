@@ -0,0 +1,41 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "sdl.h"
+#include "board.h"
+#include "danger.h"
+
+#define BOT_DELAY 250
+#define BOT_SIGHT 3
+#define BOT_MOVES 10
+#define BOT_TELEPORT 0
+#define BOT_WAIT 5
+
+/*!*****************************************************************************
+	\brief	Tell where a move moves the hero, moves are numbered like the
+		keys of the keypad
+
+	\param	move
+		Keypad number of the move
+
+	\param	dx, dy
+		Step of the hero
+
+	\return	0 for a step, 1 for the teleport
+
+	\date	19.10.26
+*******************************************************************************/
+static inline int keypadStep(int move, int *dx, int *dy) {
+	if(move == BOT_TELEPORT) {
+		*dx = *dy = 0;
+		return 1;
+	}
+	*dx = (move - 1) % 3 - 1;
+	*dy = 1 - (move - 1) / 3;
+	return 0;
+}
+
+SDLKey botMove(const struct dangerMap *d, const struct board *b, int heroX, int heroY);
+int botStep(SDLKey key, int *dx, int *dy);
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+
+/*!*****************************************************************************
+	\brief	Compare the keys of two cache entries
+
+	\date	19.10.26
+*******************************************************************************/
+static int compareEntries(const void *a, const void *b) {
+	const struct cacheEntry *x = (const struct cacheEntry *)a, *y = (const struct cacheEntry *)b;
+
+	if(x->w != y->w) {
+		return (x->w < y->w)? -1: 1;
+	}
+	if(x->h != y->h) {
+		return (x->h < y->h)? -1: 1;
+	}
+	return (x->number < y->number)? -1: (x->number > y->number)? 1: 0;
+}
+
+/*!*****************************************************************************
+	\brief	Read a level cache file
+
+	A missing file is an empty cache.
+
+	\param	c
+		Cache handler
+
+	\param	path
+		File to read
+
+	\return	0 on success, -1 if the file is broken or out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int loadLevelCache(struct levelCache *c, const char *path) {
+	struct cacheHeader header;
+	FILE *fp;
+	int i;
+
+	memset(c, 0, sizeof(*c));
+	if((fp = fopen(path, "rb")) == NULL) {
+		return 0;
+	}
+	if((fread(&header, sizeof(header), 1, fp) != 1) || (header.magic != CACHE_MAGIC) || (header.version != CACHE_VERSION) ||
+		((c->entries = malloc(((size_t)header.count + 1) * sizeof(*c->entries))) == NULL) ||
+		(fread(c->entries, sizeof(*c->entries), header.count, fp) != header.count)) {
+		fprintf(stderr, "Level cache %s is not for this game\n", path);
+		fclose(fp);
+		freeLevelCache(c);
+		return -1;
+	}
+	fclose(fp);
+	c->count = c->size = (int)header.count;
+	for(i=0; i<c->count; i++) {
+		if((c->entries[i].variants < 0) || (c->entries[i].variants > CACHE_VARIANTS) ||
+			((i > 0) && (compareEntries(&c->entries[i - 1], &c->entries[i]) >= 0))) {
+			fprintf(stderr, "Level cache %s is broken\n", path);
+			freeLevelCache(c);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Look up the verified seeds of a level
+
+	\param	c
+		Cache handler
+
+	\param	w, h
+		Size of the field
+
+	\param	number
+		Number of the level
+
+	\return	Entry of the level, NULL if there is none
+
+	\date	19.10.26
+*******************************************************************************/
+const struct cacheEntry *findCachedLevel(const struct levelCache *c, int w, int h, int number) {
+	struct cacheEntry key;
+
+	if(!c->count) {
+		return NULL;
+	}
+	key.w = w;
+	key.h = h;
+	key.number = number;
+	return bsearch(&key, c->entries, c->count, sizeof(*c->entries), compareEntries);
+}
+
+/*!*****************************************************************************
+	\brief	Add a level to the cache, or replace it if it is there already
+
+	\param	c
+		Cache handler
+
+	\param	entry
+		Level to store
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int storeCachedLevel(struct levelCache *c, const struct cacheEntry *entry) {
+	struct cacheEntry *grown;
+	int at, size;
+
+	for(at=c->count; (at > 0) && (compareEntries(&c->entries[at - 1], entry) > 0); at--);
+	if((at > 0) && !compareEntries(&c->entries[at - 1], entry)) {
+		c->entries[at - 1] = *entry;
+		return 0;
+	}
+	if(c->count == c->size) {
+		size = c->size? c->size * 2: 64;
+		if((grown = realloc(c->entries, size * sizeof(*c->entries))) == NULL) {
+			return -1;
+		}
+		c->entries = grown;
+		c->size = size;
+	}
+	memmove(&c->entries[at + 1], &c->entries[at], (c->count - at) * sizeof(*c->entries));
+	c->entries[at] = *entry;
+	c->count++;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Write the cache to a file
+
+	The cache is written next to the file first and then renamed over it, so
+	a game reading the old file never sees half of the new one.
+
+	\param	c
+		Cache handler
+
+	\param	path
+		File to write
+
+	\return	0 on success, -1 on a write error
+
+	\date	19.10.26
+*******************************************************************************/
+int saveLevelCache(const struct levelCache *c, const char *path) {
+	struct cacheHeader header = { CACHE_MAGIC, CACHE_VERSION, 0, 0 };
+	char *temporary;
+	FILE *fp;
+	int failed;
+
+	if((temporary = malloc(strlen(path) + 5)) == NULL) {
+		return -1;
+	}
+	sprintf(temporary, "%s.new", path);
+	if((fp = fopen(temporary, "wb")) == NULL) {
+		perror(temporary);
+		free(temporary);
+		return -1;
+	}
+	header.count = (uint32_t)c->count;
+	failed = (fwrite(&header, sizeof(header), 1, fp) != 1) ||
+		(fwrite(c->entries, sizeof(*c->entries), c->count, fp) != (size_t)c->count);
+	failed |= fclose(fp) != 0;
+	if(failed || rename(temporary, path)) {
+		perror(path);
+		remove(temporary);
+		free(temporary);
+		return -1;
+	}
+	free(temporary);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Free the memory of a cache
+
+	\param	c
+		Cache handler
+
+	\date	19.10.26
+*******************************************************************************/
+void freeLevelCache(struct levelCache *c) {
+	free(c->entries);
+	memset(c, 0, sizeof(*c));
+}
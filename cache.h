@@ -0,0 +1,56 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+
+#define CACHE_MAGIC	0x4C425452
+#define CACHE_VERSION	1
+#define CACHE_VARIANTS	8
+
+/*!*****************************************************************************
+	\brief	Start of a level cache file, followed by count entries
+
+	\date	19.10.26
+*******************************************************************************/
+struct cacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t unused;
+};
+
+/*!*****************************************************************************
+	\brief	Verified seeds of one level on one field size
+
+	Entries are kept sorted by field size and level number, so they are
+	their own index.
+
+	\date	19.10.26
+*******************************************************************************/
+struct cacheEntry {
+	int32_t w, h;
+	int32_t number;
+	int32_t robots;
+	int32_t variants;
+	uint32_t unused;
+	uint64_t seed[CACHE_VARIANTS];
+};
+
+/*!*****************************************************************************
+	\brief	Level cache read to memory
+
+	\date	19.10.26
+*******************************************************************************/
+struct levelCache {
+	struct cacheEntry *entries;
+	int count;
+	int size;
+};
+
+int loadLevelCache(struct levelCache *c, const char *path);
+const struct cacheEntry *findCachedLevel(const struct levelCache *c, int w, int h, int number);
+int storeCachedLevel(struct levelCache *c, const struct cacheEntry *entry);
+int saveLevelCache(const struct levelCache *c, const char *path);
+void freeLevelCache(struct levelCache *c);
+
+#endif
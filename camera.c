@@ -0,0 +1,127 @@
+#include "defs.h"
+#include "camera.h"
+
+struct camera camera;
+
+// Cell sizes of the zoom steps in percents of the normal cell size
+static const int zoomPercents[ZOOM_LEVELS] = { 10, 20, 50, 100, 150, 200 };
+
+/*!*****************************************************************************
+	\brief	Divide rounding towards negative infinity
+
+	\date	19.10.26
+*******************************************************************************/
+static int floorDiv(int a, int b) {
+	return (a >= 0)? a / b: -((b - 1 - a) / b);
+}
+
+/*!*****************************************************************************
+	\brief	Get the cell size of the current zoom step
+
+	\date	19.10.26
+*******************************************************************************/
+static int zoomedCell(const struct camera *c) {
+	int cell = c->base * zoomPercents[c->zoom] / 100;
+	return (cell < 1)? 1: cell;
+}
+
+/*!*****************************************************************************
+	\brief	Set the camera to the normal cell size
+
+	\param	c
+		Camera handler
+
+	\param	w, h
+		Size of the view in pixels
+
+	\param	cell
+		Normal size of a cell in pixels
+
+	\date	19.10.26
+*******************************************************************************/
+void initCamera(struct camera *c, int w, int h, int cell) {
+	c->x = 0;
+	c->y = 0;
+	c->w = w;
+	c->h = h;
+	c->base = cell;
+	c->zoom = 3;
+	c->cell = zoomedCell(c);
+}
+
+/*!*****************************************************************************
+	\brief	Change the cell size of the camera by one step
+
+	\param	c
+		Camera handler
+
+	\param	in
+		Non-zero to show the cells bigger, zero to show more of them
+
+	\date	19.10.26
+*******************************************************************************/
+void zoomCamera(struct camera *c, int in) {
+	if(in && (c->zoom < ZOOM_LEVELS - 1)) {
+		c->zoom++;
+	}
+	else if(!in && (c->zoom > 0)) {
+		c->zoom--;
+	}
+	c->cell = zoomedCell(c);
+}
+
+/*!*****************************************************************************
+	\brief	Center the camera on the hero without showing past the field edges
+
+	A field smaller than the view is centered in it.
+
+	\param	c
+		Camera handler
+
+	\param	b
+		Field to be shown
+
+	\param	heroX, heroY
+		Position of the hero
+
+	\date	19.10.26
+*******************************************************************************/
+void followHero(struct camera *c, const struct board *b, int heroX, int heroY) {
+	int width = b->w * c->cell, height = b->h * c->cell;
+
+	c->x = heroX * c->cell + c->cell / 2 - c->w / 2;
+	c->y = heroY * c->cell + c->cell / 2 - c->h / 2;
+	c->x = (width <= c->w)? (width - c->w) / 2: (c->x < 0)? 0: (c->x > width - c->w)? width - c->w: c->x;
+	c->y = (height <= c->h)? (height - c->h) / 2: (c->y < 0)? 0: (c->y > height - c->h)? height - c->h: c->y;
+}
+
+/*!*****************************************************************************
+	\brief	Get the cells shown between two rows of the view
+
+	\param	c
+		Camera handler
+
+	\param	b
+		Field to be shown
+
+	\param	top, bottom
+		First row and the row after the last one of the view
+
+	\param	x0, y0, x1, y1
+		First and last visible cell
+
+	\return	0 if some cells are visible, -1 if none
+
+	\date	19.10.26
+*******************************************************************************/
+int visibleCells(const struct camera *c, const struct board *b, int top, int bottom, int *x0, int *y0, int *x1, int *y1) {
+	*x0 = floorDiv(c->x, c->cell);
+	*x1 = floorDiv(c->x + c->w - 1, c->cell);
+	*y0 = floorDiv(c->y + top, c->cell);
+	*y1 = floorDiv(c->y + bottom - 1, c->cell);
+	*x0 = (*x0 < 0)? 0: *x0;
+	*y0 = (*y0 < 0)? 0: *y0;
+	*x1 = (*x1 >= b->w)? b->w - 1: *x1;
+	*y1 = (*y1 >= b->h)? b->h - 1: *y1;
+	return ((*x0 > *x1) || (*y0 > *y1) || (top >= bottom))? -1: 0;
+}
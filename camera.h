@@ -0,0 +1,28 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "board.h"
+
+#define ZOOM_LEVELS 6
+
+/*!*****************************************************************************
+	\brief	View of the field shown in the window
+
+	\date	19.10.26
+*******************************************************************************/
+struct camera {
+	int x, y;
+	int w, h;
+	int zoom;
+	int base;
+	int cell;
+};
+
+extern struct camera camera;
+
+void initCamera(struct camera *c, int w, int h, int cell);
+void zoomCamera(struct camera *c, int in);
+void followHero(struct camera *c, const struct board *b, int heroX, int heroY);
+int visibleCells(const struct camera *c, const struct board *b, int top, int bottom, int *x0, int *y0, int *x1, int *y1);
+
+#endif
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "pipeline.h"
+#include "camera.h"
+#include "bands.h"
+#include "capture.h"
+
+/*
+	Frames are written either as a stream of binary PPM images, or as a
+	YUV4MPEG2 stream in 4:4:4 when the file name ends with .y4m. Both can
+	be read by ffmpeg, e.g. ffmpeg -f image2pipe -c:v ppm -r 25 -i - out.mp4
+*/
+
+static FILE *out;
+static int y4m;
+static int fps;
+static int width, height;
+static Uint8 *image;
+static int *looks;
+static int lookCols, lookRows;
+static struct camera lastCamera;
+static int lastScreen = -1, lastText, lastLevel;
+static SDL_Rect lastHud;
+static int *dirty;
+
+/*!*****************************************************************************
+	\brief	Start writing frames to a file
+
+	\param	path
+		File to write to, - for the standard output
+
+	\param	rate
+		Frames a second, written in the header of a YUV4MPEG2 stream
+
+	\return	0 on success, -1 if the file could not be created
+
+	\date	19.10.26
+*******************************************************************************/
+int openCapture(const char *path, int rate) {
+	size_t length = strlen(path);
+
+	fps = rate;
+	y4m = (length > 4) && !strcmp(path + length - 4, ".y4m");
+	if(!strcmp(path, "-")) {
+		out = stdout;
+	}
+	else if((out = fopen(path, "wb")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get a value telling how a cell looks, equal values look the same
+
+	\param	f
+		Frame being drawn
+
+	\param	x, y
+		Position of the cell on the field
+
+	\date	19.10.26
+*******************************************************************************/
+static int cellLook(const struct frame *f, int x, int y) {
+	int item = CELL(&f->playfield, x, y), shade = dangerShade(f, x, y) << 16;
+
+	switch(item) {
+		case ROBOT:
+			return ROBOT | (getDirection(f, x, y) << 8) | shade;
+		case HERO:
+			return HERO | (f->heroImage << 8) | shade;
+		case MOVED_ROBOT:
+			return EMPTY | shade;
+	}
+	return item | shade;
+}
+
+/*!*****************************************************************************
+	\brief	Convert a rectangle of the screen to the output image
+
+	\param	rect
+		Area of the screen, clipped to the screen by the caller
+
+	\date	19.10.26
+*******************************************************************************/
+static void convertRect(SDL_Rect *rect) {
+	int x, y, bpp = screen->format->BytesPerPixel;
+	Uint8 r, g, b, *src;
+	Uint32 pixel = 0;
+	size_t plane = (size_t)width * height, i;
+
+	if(SDL_MUSTLOCK(screen) && (SDL_LockSurface(screen) < 0)) {
+		return;
+	}
+	for(y=rect->y; y<rect->y + rect->h; y++) {
+		src = (Uint8 *)screen->pixels + y * screen->pitch + rect->x * bpp;
+		for(x=rect->x; x<rect->x + rect->w; x++, src += bpp) {
+			switch(bpp) {
+				case 1:
+					pixel = *src;
+				break;
+				case 2:
+					pixel = *(Uint16 *)src;
+				break;
+				case 3:
+					pixel = src[0] | (src[1] << 8) | (src[2] << 16);
+				break;
+				default:
+					pixel = *(Uint32 *)src;
+				break;
+			}
+			SDL_GetRGB(pixel, screen->format, &r, &g, &b);
+			i = (size_t)y * width + x;
+			if(y4m) {
+				// BT.601 studio range
+				image[i] = (Uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				image[plane + i] = (Uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				image[2 * plane + i] = (Uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+			else {
+				image[3 * i] = r;
+				image[3 * i + 1] = g;
+				image[3 * i + 2] = b;
+			}
+		}
+	}
+	if(SDL_MUSTLOCK(screen)) {
+		SDL_UnlockSurface(screen);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Clip a rectangle to the screen
+
+	\return	0 if some of the rectangle is left, -1 if none
+
+	\date	19.10.26
+*******************************************************************************/
+static int clipToScreen(SDL_Rect *rect, int x, int y, int w, int h) {
+	int right = x + w, bottom = y + h;
+
+	x = (x < 0)? 0: x;
+	y = (y < 0)? 0: y;
+	right = (right > screen->w)? screen->w: right;
+	bottom = (bottom > screen->h)? screen->h: bottom;
+	if((x >= right) || (y >= bottom)) {
+		return -1;
+	}
+	initRectangle(rect, x, y, right - x, bottom - y);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Check if two rectangles overlap
+
+	\date	19.10.26
+*******************************************************************************/
+static int overlaps(const SDL_Rect *a, int x, int y, int w, int h) {
+	return (x < a->x + a->w) && (a->x < x + w) && (y < a->y + a->h) && (a->y < y + h);
+}
+
+/*!*****************************************************************************
+	\brief	Draw the whole frame and forget the looks of the cells
+
+	\param	f
+		Frame to be drawn
+
+	\date	19.10.26
+*******************************************************************************/
+static void drawFull(const struct frame *f) {
+	SDL_Rect rect;
+	int x, y, x0, y0, x1, y1;
+
+	drawEverything(f);
+	initRectangle(&rect, 0, 0, screen->w, screen->h);
+	convertRect(&rect);
+	if(looks == NULL) {
+		return;
+	}
+	memset(looks, 0xFF, (size_t)lookCols * lookRows * sizeof(*looks));
+	if((f->screen == SCREEN_FIELD) && !visibleCells(&camera, &f->playfield, 0, screen->h, &x0, &y0, &x1, &y1)) {
+		for(y=y0; y<=y1; y++) {
+			for(x=x0; x<=x1; x++) {
+				looks[(y - y0) * lookCols + (x - x0)] = cellLook(f, x, y);
+			}
+		}
+		getHudRect(f, &lastHud);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Draw only the cells that look different from the last frame
+
+	\param	f
+		Frame to be drawn
+
+	\date	19.10.26
+*******************************************************************************/
+static void drawChanges(const struct frame *f) {
+	SDL_Rect hud, rect;
+	int x, y, x0, y0, x1, y1, look, count = 0, i;
+
+	getHudRect(f, &hud);
+	// The old and new teleport counter both have to be covered
+	if(lastHud.w) {
+		x = (hud.x + hud.w > lastHud.x + lastHud.w)? hud.x + hud.w: lastHud.x + lastHud.w;
+		y = (hud.y + hud.h > lastHud.y + lastHud.h)? hud.y + hud.h: lastHud.y + lastHud.h;
+		hud.x = (hud.x < lastHud.x)? hud.x: lastHud.x;
+		hud.y = (hud.y < lastHud.y)? hud.y: lastHud.y;
+		hud.w = x - hud.x;
+		hud.h = y - hud.y;
+	}
+	if(visibleCells(&camera, &f->playfield, 0, screen->h, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	if(SDL_MUSTLOCK(screen) && (SDL_LockSurface(screen) < 0)) {
+		return;
+	}
+	for(y=y0; y<=y1; y++) {
+		for(x=x0; x<=x1; x++) {
+			look = cellLook(f, x, y);
+			i = (y - y0) * lookCols + (x - x0);
+			if((look != looks[i]) || overlaps(&hud, x * camera.cell - camera.x, y * camera.cell - camera.y, camera.cell, camera.cell)) {
+				redrawCell(f, x, y);
+				looks[i] = look;
+				dirty[count++] = i;
+			}
+		}
+	}
+	if(SDL_MUSTLOCK(screen)) {
+		SDL_UnlockSurface(screen);
+	}
+	drawHud(f);
+	getHudRect(f, &lastHud);
+	for(i=0; i<count; i++) {
+		x = x0 + dirty[i] % lookCols;
+		y = y0 + dirty[i] / lookCols;
+		if(!clipToScreen(&rect, x * camera.cell - camera.x, y * camera.cell - camera.y, camera.cell, camera.cell)) {
+			convertRect(&rect);
+		}
+	}
+	if(!clipToScreen(&rect, hud.x, hud.y, hud.w, hud.h)) {
+		convertRect(&rect);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Draw a frame and write it to the capture file
+
+	Only cells that changed since the previous frame are drawn and converted,
+	unless the camera moved or a text screen is shown.
+
+	\param	f
+		Frame to be written
+
+	\return	0 on success, -1 on a write error
+
+	\date	19.10.26
+*******************************************************************************/
+int writeCapture(const struct frame *f) {
+	size_t size;
+	int full;
+
+	if(image == NULL) {
+		width = screen->w;
+		height = screen->h;
+		if((image = malloc((size_t)width * height * 3)) == NULL) {
+			return -1;
+		}
+		if(y4m) {
+			fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+		}
+	}
+	full = (f->screen != lastScreen) || (f->screen != SCREEN_FIELD) || !bandsAvailable();
+	if(f->screen == SCREEN_FIELD) {
+		followHero(&camera, &f->playfield, f->heroX, f->heroY);
+		full |= (camera.x != lastCamera.x) || (camera.y != lastCamera.y) || (camera.cell != lastCamera.cell);
+		if((looks == NULL) || (camera.cell != lastCamera.cell)) {
+			free(looks);
+			free(dirty);
+			lookCols = screen->w / camera.cell + 2;
+			lookRows = screen->h / camera.cell + 2;
+			looks = malloc((size_t)lookCols * lookRows * sizeof(*looks));
+			dirty = malloc((size_t)lookCols * lookRows * sizeof(*dirty));
+			if((looks == NULL) || (dirty == NULL)) {
+				return -1;
+			}
+		}
+	}
+	else {
+		full |= (f->text != lastText) || (f->currentLevel != lastLevel);
+	}
+	if(full) {
+		drawFull(f);
+	}
+	else if(f->screen == SCREEN_FIELD) {
+		drawChanges(f);
+	}
+	lastScreen = f->screen;
+	lastText = f->text;
+	lastLevel = f->currentLevel;
+	lastCamera = camera;
+
+	size = (size_t)width * height * 3;
+	if(y4m) {
+		fputs("FRAME\n", out);
+	}
+	else {
+		fprintf(out, "P6\n%d %d\n255\n", width, height);
+	}
+	return (fwrite(image, 1, size, out) == size)? 0: -1;
+}
+
+/*!*****************************************************************************
+	\brief	Finish writing frames
+
+	\date	19.10.26
+*******************************************************************************/
+void closeCapture(void) {
+	if((out != NULL) && (out != stdout)) {
+		fclose(out);
+	}
+	else if(out != NULL) {
+		fflush(out);
+	}
+	out = NULL;
+	free(image);
+	free(looks);
+	free(dirty);
+	image = NULL;
+	looks = NULL;
+	dirty = NULL;
+}
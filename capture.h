@@ -0,0 +1,13 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "pipeline.h"
+
+#define CAPTURE_FPS 25
+#define CAPTURE_TAIL 2000
+
+int openCapture(const char *path, int rate);
+int writeCapture(const struct frame *f);
+void closeCapture(void);
+
+#endif
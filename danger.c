@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "defs.h"
+#include "board.h"
+#include "danger.h"
+
+/*!*****************************************************************************
+	\brief	Tell what an item on the field is to the danger map
+
+	\param	item
+		Content of a cell
+
+	\date	19.10.26
+*******************************************************************************/
+static int kindOf(char item) {
+	switch(item) {
+		case ROBOT:
+		case MOVED_ROBOT:
+			return DANGER_ROBOT;
+		case TRASH:
+		case EXPLOSION:
+		case HERO_EXPLOSION:
+			return DANGER_BLOCKED;
+		default:
+			return DANGER_FREE;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Reserve a danger map for a field
+
+	\param	d
+		Danger map handler
+
+	\param	w, h
+		Size of the field
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int createDanger(struct dangerMap *d, int w, int h) {
+	memset(d, 0, sizeof(*d));
+	d->w = w;
+	d->h = h;
+	d->distance = malloc((size_t)w * h * sizeof(*d->distance));
+	d->kind = malloc((size_t)w * h);
+	d->before = malloc((size_t)w * h * sizeof(*d->before));
+	d->queue = malloc((size_t)w * h * sizeof(*d->queue));
+	if((d->distance == NULL) || (d->kind == NULL) || (d->before == NULL) || (d->queue == NULL)) {
+		freeDanger(d);
+		return -1;
+	}
+	// Matches an empty board until rebuilt
+	memset(d->distance, 0xFF, (size_t)w * h * sizeof(*d->distance));
+	memset(d->kind, DANGER_FREE, (size_t)w * h);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Free the memory of a danger map
+
+	\param	d
+		Danger map handler
+
+	\date	19.10.26
+*******************************************************************************/
+void freeDanger(struct dangerMap *d) {
+	free(d->distance);
+	free(d->kind);
+	free(d->before);
+	free(d->queue);
+	free(d->heap);
+	memset(d, 0, sizeof(*d));
+}
+
+/*!*****************************************************************************
+	\brief	Count the distances of the whole field again
+
+	Breadth first search from all robots at once.
+
+	\param	d
+		Danger map handler
+
+	\param	b
+		Playfield
+
+	\date	19.10.26
+*******************************************************************************/
+void rebuildDanger(struct dangerMap *d, const struct board *b) {
+	int i, n, x, y, dx, dy, head = 0, tail = 0;
+
+	for(i=0; i<d->w*d->h; i++) {
+		d->kind[i] = kindOf(b->cells[i]);
+		if(d->kind[i] == DANGER_ROBOT) {
+			d->distance[i] = 0;
+			d->queue[tail++] = i;
+		}
+		else {
+			d->distance[i] = DANGER_FAR;
+		}
+	}
+	while(head < tail) {
+		i = d->queue[head++];
+		x = i % d->w;
+		y = i / d->w;
+		for(dy=-1; dy<=1; dy++) {
+			for(dx=-1; dx<=1; dx++) {
+				if((x + dx < 0) || (y + dy < 0) || (x + dx >= d->w) || (y + dy >= d->h)) {
+					continue;
+				}
+				n = i + dy * d->w + dx;
+				if((d->kind[n] == DANGER_FREE) && (d->distance[n] == DANGER_FAR)) {
+					d->distance[n] = d->distance[i] + 1;
+					d->queue[tail++] = n;
+				}
+			}
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Add a cell to the heap of cells whose distance can spread
+
+	\param	d
+		Danger map handler
+
+	\param	i
+		Index of the cell
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+static int pushStep(struct dangerMap *d, int i) {
+	struct dangerStep step, *grown;
+	int at, parent, size;
+
+	if(d->heapCount == d->heapSize) {
+		size = d->heapSize? d->heapSize * 2: 256;
+		if((grown = realloc(d->heap, size * sizeof(*d->heap))) == NULL) {
+			return -1;
+		}
+		d->heap = grown;
+		d->heapSize = size;
+	}
+	step.distance = d->distance[i];
+	step.index = i;
+	for(at=d->heapCount++; at>0; at=parent) {
+		parent = (at - 1) / 2;
+		if(d->heap[parent].distance <= step.distance) {
+			break;
+		}
+		d->heap[at] = d->heap[parent];
+	}
+	d->heap[at] = step;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Take the cell with the shortest distance from the heap
+
+	\param	d
+		Danger map handler
+
+	\date	19.10.26
+*******************************************************************************/
+static struct dangerStep popStep(struct dangerMap *d) {
+	struct dangerStep top = d->heap[0], last = d->heap[--d->heapCount];
+	int at = 0, child;
+
+	while((child = at * 2 + 1) < d->heapCount) {
+		if((child + 1 < d->heapCount) && (d->heap[child + 1].distance < d->heap[child].distance)) {
+			child++;
+		}
+		if(last.distance <= d->heap[child].distance) {
+			break;
+		}
+		d->heap[at] = d->heap[child];
+		at = child;
+	}
+	d->heap[at] = last;
+	return top;
+}
+
+/*!*****************************************************************************
+	\brief	Tell if a free cell still has a neighbour one move nearer a robot
+
+	\param	d
+		Danger map handler
+
+	\param	i
+		Index of the cell
+
+	\date	19.10.26
+*******************************************************************************/
+static int supported(const struct dangerMap *d, int i) {
+	int x = i % d->w, y = i / d->w, dx, dy, n;
+
+	for(dy=-1; dy<=1; dy++) {
+		for(dx=-1; dx<=1; dx++) {
+			if((x + dx < 0) || (y + dy < 0) || (x + dx >= d->w) || (y + dy >= d->h)) {
+				continue;
+			}
+			n = i + dy * d->w + dx;
+			if((d->kind[n] != DANGER_BLOCKED) && (d->distance[n] + 1 == d->distance[i])) {
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Clear the distance of a cell, remembering the old one
+
+	\param	d
+		Danger map handler
+
+	\param	i
+		Index of the cell
+
+	\param	tail
+		Queue of cleared cells to add the cell to
+
+	\date	19.10.26
+*******************************************************************************/
+static void clearDistance(struct dangerMap *d, int i, int *tail) {
+	d->before[i] = d->distance[i];
+	d->distance[i] = DANGER_FAR;
+	d->queue[(*tail)++] = i;
+}
+
+/*!*****************************************************************************
+	\brief	Bring the danger map up to date with the journal of the playfield
+
+	Cells whose distance may have grown are cleared first, spreading only as
+	far as the cells that lost the neighbour their distance came from. The
+	distances then spread again from the cells around the cleared ones and
+	from new robots, nearest first. A reset journal counts the whole field.
+	The caller clears the journal.
+
+	\param	d
+		Danger map handler
+
+	\param	b
+		Playfield with a journal
+
+	\date	19.10.26
+*******************************************************************************/
+void updateDanger(struct dangerMap *d, const struct board *b) {
+	const struct journal *j = b->journal;
+	struct dangerStep step;
+	int c, i, n, x, y, dx, dy, kind, head = 0, tail = 0;
+
+	if((j == NULL) || j->reset) {
+		rebuildDanger(d, b);
+		return;
+	}
+	d->heapCount = 0;
+	for(c=0; c<j->count; c++) {
+		i = j->changes[c].index;
+		if((kind = kindOf(b->cells[i])) == d->kind[i]) {
+			continue;
+		}
+		d->kind[i] = kind;
+		if(kind == DANGER_ROBOT) {
+			d->distance[i] = 0;
+			if(pushStep(d, i)) {
+				rebuildDanger(d, b);
+				return;
+			}
+		}
+		else {
+			// Blocked cells have no distance, an opened one is filled in from around
+			clearDistance(d, i, &tail);
+		}
+	}
+	for(head=0; head<tail; head++) {
+		i = d->queue[head];
+		if(d->before[i] == DANGER_FAR) {
+			continue;
+		}
+		x = i % d->w;
+		y = i / d->w;
+		for(dy=-1; dy<=1; dy++) {
+			for(dx=-1; dx<=1; dx++) {
+				if((x + dx < 0) || (y + dy < 0) || (x + dx >= d->w) || (y + dy >= d->h)) {
+					continue;
+				}
+				n = i + dy * d->w + dx;
+				if((d->kind[n] == DANGER_FREE) && (d->distance[n] == d->before[i] + 1) && !supported(d, n)) {
+					clearDistance(d, n, &tail);
+				}
+			}
+		}
+	}
+	// Everything next to a cleared cell spreads into it again
+	for(c=0; c<tail; c++) {
+		i = d->queue[c];
+		x = i % d->w;
+		y = i / d->w;
+		for(dy=-1; dy<=1; dy++) {
+			for(dx=-1; dx<=1; dx++) {
+				if((x + dx < 0) || (y + dy < 0) || (x + dx >= d->w) || (y + dy >= d->h)) {
+					continue;
+				}
+				n = i + dy * d->w + dx;
+				if((d->kind[n] != DANGER_BLOCKED) && (d->distance[n] != DANGER_FAR) && pushStep(d, n)) {
+					rebuildDanger(d, b);
+					return;
+				}
+			}
+		}
+	}
+	while(d->heapCount > 0) {
+		step = popStep(d);
+		i = step.index;
+		if(step.distance != d->distance[i]) {
+			continue;
+		}
+		x = i % d->w;
+		y = i / d->w;
+		for(dy=-1; dy<=1; dy++) {
+			for(dx=-1; dx<=1; dx++) {
+				if((x + dx < 0) || (y + dy < 0) || (x + dx >= d->w) || (y + dy >= d->h)) {
+					continue;
+				}
+				n = i + dy * d->w + dx;
+				if((d->kind[n] == DANGER_FREE) && (d->distance[n] > step.distance + 1)) {
+					d->distance[n] = step.distance + 1;
+					if(pushStep(d, n)) {
+						rebuildDanger(d, b);
+						return;
+					}
+				}
+			}
+		}
+	}
+}
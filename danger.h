@@ -0,0 +1,65 @@
+#ifndef DANGER_H
+#define DANGER_H
+
+#include "board.h"
+
+#define DANGER_FAR 0xFFFF
+
+/*!*****************************************************************************
+	\brief	What a cell is to the danger map
+
+	\date	19.10.26
+*******************************************************************************/
+enum {
+	DANGER_FREE=0,
+	DANGER_ROBOT,
+	DANGER_BLOCKED,
+};
+
+/*!*****************************************************************************
+	\brief	Distance from every cell to the nearest robot
+
+	Distances are in robot moves, counted in all eight directions around the
+	trash heaps. The map follows the journal of the playfield, so only the
+	cells near a change are looked at again.
+
+	\date	19.10.26
+*******************************************************************************/
+struct dangerMap {
+	int w, h;
+	unsigned short *distance;
+	unsigned char *kind;
+	unsigned short *before;
+	int *queue;
+	struct dangerStep {
+		unsigned short distance;
+		int index;
+	} *heap;
+	int heapCount, heapSize;
+};
+
+int createDanger(struct dangerMap *d, int w, int h);
+void freeDanger(struct dangerMap *d);
+void rebuildDanger(struct dangerMap *d, const struct board *b);
+void updateDanger(struct dangerMap *d, const struct board *b);
+
+/*!*****************************************************************************
+	\brief	Get the moves a robot needs to reach a cell
+
+	\param	d
+		Danger map handler
+
+	\param	x, y
+		Position of the cell
+
+	\return	0 on robots and trash, DANGER_FAR if no robot can reach the cell
+
+	\date	19.10.26
+*******************************************************************************/
+static inline int dangerAt(const struct dangerMap *d, int x, int y) {
+	int i = y * d->w + x;
+
+	return (d->kind[i] == DANGER_FREE)? d->distance[i]: 0;
+}
+
+#endif
@@ -1,13 +1,23 @@
-#include "SDL/SDL.h"	
+#ifndef DEFS_H
+#define DEFS_H
+
+#include "sdl.h"
+#include "board.h"
 
 #define	NO_X	11
 #define NO_Y	5
 
 #define ROBOCOUNT 10
+#ifndef FIELD_X
 #define FIELD_X 16
+#endif
+#ifndef FIELD_Y
 #define FIELD_Y 12
+#endif
 #define FIELD_WIDTH 50
 
+#define ANIMATION_STEP 1000
+
 enum robots {
 	EMPTY=0,
 	ROBOT,
@@ -18,24 +28,41 @@ enum robots {
 	HERO_EXPLOSION,
 };
 
-SDL_Surface *screen;
-SDL_Surface *sprites;
-SDL_Surface *robot;
-SDL_Surface *hero;
-SDL_Surface *trash;
+struct frame;
+
+extern SDL_Surface *screen;
+extern SDL_Surface *sprites;
+extern SDL_Surface *robot;
+extern SDL_Surface *hero;
+extern SDL_Surface *trash;
 
-SDL_Color white = { 0xFF, 0xFF, 0xFF, 0 };
-SDL_Color black = { 0x00, 0x00, 0x00, 0 };
-SDL_Color *forecol;
-SDL_Color *backcol;	
+extern SDL_Color white;
+extern SDL_Color black;
+extern SDL_Color *forecol;
+extern SDL_Color *backcol;	
 	
-SDL_Rect dstrect, srcrect;
+extern SDL_Rect dstrect, srcrect;
 
-TTF_Font *font;
+extern TTF_Font *font;
 	
-char playfield[FIELD_X][FIELD_Y];
-int robotCount, currentLevel, HERO_X, HERO_Y,  updateMovement, HERO_MOVEMENT, safeTeleports, robotsKilled;
+extern struct board playfield;
+extern int robotCount, currentLevel, HERO_X, HERO_Y,  updateMovement, HERO_MOVEMENT, safeTeleports, robotsKilled;
+extern unsigned int animationTime;
+extern int dangerOverlay;
 	
 int createSurfaces(void);	
-int drawEverything(void);
+int drawEverything(const struct frame *f);
+void initRectangle(SDL_Rect *rect, int x, int y, int w, int h);
+int getRobotImage(SDL_Rect *rect, int image);
+int getHeroImage(SDL_Rect *rect, int image);
+int getDirection(const struct frame *f, int x, int y);
+void showPlayfield(void);
+void hudText(const struct frame *f, char *text);
+void drawHud(const struct frame *f);
+void getHudRect(const struct frame *f, SDL_Rect *rect);
+int dangerShade(const struct frame *f, int x, int y);
+void drawDanger(const struct frame *f, int x, int y);
+int firstRobotCount(void);
+int nextRobotCount(int robots);
 
+#endif
@@ -0,0 +1,193 @@
+#include <stdio.h>
+
+extern "C" {
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "advisor.h"
+}
+#include "kernels.h"
+
+/*
+	The turn loops of the standard field sizes, with the width and height
+	as template arguments. Strides and bounds become constants, so the
+	compiler can unroll and vectorize them. The moves are made in exactly
+	the same order as in stepRobots, journal included.
+*/
+
+/*!*****************************************************************************
+	\brief	Kernels of a field of W x H cells
+
+	\date	19.10.26
+*******************************************************************************/
+template<int W, int H>
+struct sized {
+	static const int chunksX = (W + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+
+	/*!*********************************************************************
+		\brief	setCell with a constant width
+
+		\date	19.10.26
+	***********************************************************************/
+	static inline void put(struct board *b, int x, int y, char item) {
+		char *cell = &b->cells[y * W + x];
+
+		if(b->journal != NULL) {
+			logChange(b->journal, y * W + x, *cell);
+		}
+		b->occupied[(y >> CHUNK_SHIFT) * chunksX + (x >> CHUNK_SHIFT)] += (item != 0) - (*cell != 0);
+		*cell = item;
+	}
+
+	/*!*********************************************************************
+		\brief	Move one robot towards the hero
+
+		\return	1 if the robot caught the hero, 0 otherwise
+
+		\date	19.10.26
+	***********************************************************************/
+	static inline int move(struct board *b, int x, int y, int heroX, int heroY, int *killed, int forward) {
+		int moveX = (x < heroX)? x+1: (x > heroX)? x-1: x;
+		int moveY = (y < heroY)? y+1: (y > heroY)? y-1: y;
+		char target = b->cells[moveY * W + moveX];
+
+		if(forward) {
+			put(b, x, y, EMPTY);
+		}
+		if(target == HERO) {
+			put(b, moveX, moveY, HERO_EXPLOSION);
+			return 1;
+		}
+		if(!forward) {
+			put(b, x, y, EMPTY);
+		}
+		if(target != EMPTY) {
+			*killed += (target == MOVED_ROBOT)? 2: 1;
+			put(b, moveX, moveY, EXPLOSION);
+		}
+		else {
+			put(b, moveX, moveY, MOVED_ROBOT);
+		}
+		return 0;
+	}
+
+	/*!*********************************************************************
+		\brief	stepRobots for this size
+
+		\date	19.10.26
+	***********************************************************************/
+	static int step(struct board *b, int heroX, int heroY, int *killed) {
+		const char *cells = b->cells;
+		int i, x, y;
+
+		for(i=heroY*W+heroX; i<W*H; i++) {
+			if((cells[i] == ROBOT) && move(b, i % W, i / W, heroX, heroY, killed, 1)) {
+				return 1;
+			}
+		}
+		for(i=heroY*W+heroX; i>=0; i--) {
+			if((cells[i] == ROBOT) && move(b, i % W, i / W, heroX, heroY, killed, 0)) {
+				return 1;
+			}
+		}
+		// Column by column like stepRobots, so the journal is the same
+		for(x=0; x<W; x++) {
+			for(y=0; y<H; y++) {
+				if(cells[y * W + x] == MOVED_ROBOT) {
+					put(b, x, y, ROBOT);
+				}
+				else if(cells[y * W + x] == ROBOT) {
+					fprintf(stderr, "What? An unmoved robot?\n");
+				}
+			}
+		}
+		return 0;
+	}
+
+	/*!*********************************************************************
+		\brief	Count the robots on a field of this size
+
+		\date	19.10.26
+	***********************************************************************/
+	static int count(const struct board *b) {
+		const char *cells = b->cells;
+		int i, robots = 0;
+
+		for(i=0; i<W*H; i++) {
+			robots += cells[i] == ROBOT;
+		}
+		return robots;
+	}
+};
+
+/*!*****************************************************************************
+	\brief	Field sizes with kernels of their own
+
+	The default field, the medium and large standard fields, and the
+	window the advisor plays its games on.
+
+	\date	19.10.26
+*******************************************************************************/
+static const struct kernelSize {
+	int w, h;
+	stepKernel step;
+	countKernel count;
+} kernelSizes[] = {
+	{ 16, 12, sized<16, 12>::step, sized<16, 12>::count },
+	{ 64, 48, sized<64, 48>::step, sized<64, 48>::count },
+	{ 256, 192, sized<256, 192>::step, sized<256, 192>::count },
+	{ ADVISOR_WINDOW, ADVISOR_WINDOW, sized<ADVISOR_WINDOW, ADVISOR_WINDOW>::step, sized<ADVISOR_WINDOW, ADVISOR_WINDOW>::count },
+};
+
+/*!*****************************************************************************
+	\brief	Find the kernels of a field size
+
+	\param	w, h
+		Size of the field
+
+	\return	Kernel entry, NULL if the size has none
+
+	\date	19.10.26
+*******************************************************************************/
+static const struct kernelSize *findKernels(int w, int h) {
+	unsigned int i;
+
+	for(i=0; i<sizeof(kernelSizes) / sizeof(kernelSizes[0]); i++) {
+		if((kernelSizes[i].w == w) && (kernelSizes[i].h == h)) {
+			return &kernelSizes[i];
+		}
+	}
+	return NULL;
+}
+
+/*!*****************************************************************************
+	\brief	Get the robot mover built for a field size
+
+	\param	w, h
+		Size of the field
+
+	\return	Kernel, NULL if the generic stepRobots is to be used
+
+	\date	19.10.26
+*******************************************************************************/
+stepKernel findStepKernel(int w, int h) {
+	const struct kernelSize *k = findKernels(w, h);
+
+	return (k != NULL)? k->step: NULL;
+}
+
+/*!*****************************************************************************
+	\brief	Get the robot counter built for a field size
+
+	\param	w, h
+		Size of the field
+
+	\return	Kernel, NULL if the generic countRobots is to be used
+
+	\date	19.10.26
+*******************************************************************************/
+countKernel findCountKernel(int w, int h) {
+	const struct kernelSize *k = findKernels(w, h);
+
+	return (k != NULL)? k->count: NULL;
+}
@@ -0,0 +1,33 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "board.h"
+
+/*!*****************************************************************************
+	\brief	Robot mover built for one field size
+
+	Same as stepRobots, only with the size known to the compiler.
+
+	\date	19.10.26
+*******************************************************************************/
+typedef int (*stepKernel)(struct board *b, int heroX, int heroY, int *killed);
+
+/*!*****************************************************************************
+	\brief	Robot counter built for one field size
+
+	\date	19.10.26
+*******************************************************************************/
+typedef int (*countKernel)(const struct board *b);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+stepKernel findStepKernel(int w, int h);
+countKernel findCountKernel(int w, int h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "level.h"
+
+/*!*****************************************************************************
+	\brief	Put the hero and the robots of a level on its board
+
+	The board is cleared first. A sparse level is made by dropping robots
+	on random empty cells, a dense one by filling the board and taking
+	robots away from random cells, so neither ever needs more than about
+	two tries per robot.
+
+	\param	l
+		Level with the number, robots and seed set
+
+	\date	19.10.26
+*******************************************************************************/
+void makeLevel(struct level *l) {
+	unsigned long long state = l->seed ^ ((unsigned long long)l->number * 0xD1B54A32D192ED03ULL);
+	struct board *b = &l->board;
+	long long total = (long long)b->w * b->h, robots, cell, left;
+	int x, y;
+
+	cell = (long long)(nextBits(&state) % (unsigned long long)total);
+	l->heroX = (int)(cell % b->w);
+	l->heroY = (int)(cell / b->w);
+	robots = (l->robots < 0)? 0: (l->robots > total - 1)? total - 1: l->robots;
+
+	if(robots * 2 <= total) {
+		clearBoard(b);
+		setCell(b, l->heroX, l->heroY, HERO);
+		for(left=robots; left>0; ) {
+			cell = (long long)(nextBits(&state) % (unsigned long long)total);
+			x = (int)(cell % b->w);
+			y = (int)(cell / b->w);
+			if(CELL(b, x, y) == EMPTY) {
+				setCell(b, x, y, ROBOT);
+				left--;
+			}
+		}
+	}
+	else {
+		fillBoard(b, ROBOT);
+		setCell(b, l->heroX, l->heroY, HERO);
+		for(left=total - 1 - robots; left>0; ) {
+			cell = (long long)(nextBits(&state) % (unsigned long long)total);
+			x = (int)(cell % b->w);
+			y = (int)(cell / b->w);
+			if(CELL(b, x, y) == ROBOT) {
+				setCell(b, x, y, EMPTY);
+				left--;
+			}
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Level making thread, makes one requested level at a time
+
+	\param	data
+		Level maker handler
+
+	\date	19.10.26
+*******************************************************************************/
+static int levelWorker(void *data) {
+	struct levelMaker *m = (struct levelMaker *)data;
+
+	SDL_LockMutex(m->lock);
+	while(1) {
+		while(!m->requested && !m->quit) {
+			SDL_CondWait(m->wake, m->lock);
+		}
+		if(m->quit) {
+			break;
+		}
+		m->next.number = m->request.number;
+		m->next.robots = m->request.robots;
+		m->next.seed = m->request.seed;
+		m->requested = 0;
+		m->working = 1;
+		m->made = 0;
+		SDL_UnlockMutex(m->lock);
+
+		makeLevel(&m->next);
+
+		SDL_LockMutex(m->lock);
+		m->working = 0;
+		m->made = 1;
+		SDL_CondBroadcast(m->ready);
+	}
+	SDL_UnlockMutex(m->lock);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Start the level maker for a field size
+
+	Without a thread the levels are made when they are taken.
+
+	\param	m
+		Level maker handler
+
+	\param	w, h
+		Size of the field
+
+	\return	0 on success, -1 if there is no memory for the spare board
+
+	\date	19.10.26
+*******************************************************************************/
+int startLevelMaker(struct levelMaker *m, int w, int h) {
+	memset(m, 0, sizeof(*m));
+	if(createBoard(&m->next.board, w, h)) {
+		return -1;
+	}
+	m->lock = SDL_CreateMutex();
+	m->wake = SDL_CreateCond();
+	m->ready = SDL_CreateCond();
+	if((m->lock != NULL) && (m->wake != NULL) && (m->ready != NULL)) {
+		m->thread = SDL_CreateThread(levelWorker, m);
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Ask for a level to be made in the background
+
+	\param	m
+		Level maker handler
+
+	\param	number
+		Number of the level
+
+	\param	robots
+		Amount of robots on the level
+
+	\param	seed
+		Seed of the game
+
+	\date	19.10.26
+*******************************************************************************/
+void prepareLevel(struct levelMaker *m, int number, int robots, unsigned long long seed) {
+	if(m->thread == NULL) {
+		return;
+	}
+	SDL_LockMutex(m->lock);
+	m->request.number = number;
+	m->request.robots = robots;
+	m->request.seed = seed;
+	m->requested = 1;
+	SDL_CondSignal(m->wake);
+	SDL_UnlockMutex(m->lock);
+}
+
+/*!*****************************************************************************
+	\brief	Swap a level in as the playfield
+
+	Waits for the level being made, if it is the one asked for. Any other
+	level is made right away. The boards are swapped, so the old playfield
+	becomes the spare board for the next level.
+
+	\param	m
+		Level maker handler
+
+	\param	number, robots, seed
+		Level wanted, as given to prepareLevel
+
+	\param	board
+		Playfield to swap the level into
+
+	\param	heroX, heroY
+		Position of the hero on the level
+
+	\date	19.10.26
+*******************************************************************************/
+void takeLevel(struct levelMaker *m, int number, int robots, unsigned long long seed, struct board *board, int *heroX, int *heroY) {
+	if(m->thread != NULL) {
+		SDL_LockMutex(m->lock);
+		if(m->requested && ((m->request.number != number) || (m->request.robots != robots) || (m->request.seed != seed))) {
+			m->requested = 0;
+		}
+		while(m->working || m->requested) {
+			SDL_CondWait(m->ready, m->lock);
+		}
+	}
+	if(!m->made || (m->next.number != number) || (m->next.robots != robots) || (m->next.seed != seed)) {
+		m->next.number = number;
+		m->next.robots = robots;
+		m->next.seed = seed;
+		makeLevel(&m->next);
+	}
+	m->made = 0;
+	swapBoards(board, &m->next.board);
+	*heroX = m->next.heroX;
+	*heroY = m->next.heroY;
+	if(m->thread != NULL) {
+		SDL_UnlockMutex(m->lock);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Stop the level maker thread and free the spare board
+
+	\param	m
+		Level maker handler
+
+	\date	19.10.26
+*******************************************************************************/
+void stopLevelMaker(struct levelMaker *m) {
+	if(m->thread != NULL) {
+		SDL_LockMutex(m->lock);
+		m->quit = 1;
+		SDL_CondSignal(m->wake);
+		SDL_UnlockMutex(m->lock);
+		SDL_WaitThread(m->thread, NULL);
+		m->thread = NULL;
+	}
+	if(m->ready != NULL) {
+		SDL_DestroyCond(m->ready);
+	}
+	if(m->wake != NULL) {
+		SDL_DestroyCond(m->wake);
+	}
+	if(m->lock != NULL) {
+		SDL_DestroyMutex(m->lock);
+	}
+	freeBoard(&m->next.board);
+	memset(m, 0, sizeof(*m));
+}
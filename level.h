@@ -0,0 +1,63 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "sdl.h"
+#include "board.h"
+
+/*!*****************************************************************************
+	\brief	Layout of one level, the same number, robots and seed always give
+		the same layout
+
+	\date	19.10.26
+*******************************************************************************/
+struct level {
+	int number;
+	int robots;
+	unsigned long long seed;
+	int heroX, heroY;
+	struct board board;
+};
+
+/*!*****************************************************************************
+	\brief	Worker thread making the next level while the current one is played
+
+	\date	19.10.26
+*******************************************************************************/
+struct levelMaker {
+	SDL_Thread *thread;
+	SDL_mutex *lock;
+	SDL_cond *wake;
+	SDL_cond *ready;
+	int quit;
+	int requested;
+	int working;
+	int made;
+	struct level request;
+	struct level next;
+};
+
+/*!*****************************************************************************
+	\brief	Step a splitmix64 generator
+
+	Levels, the advisor, the solver and the spectator games all draw their
+	random values from one.
+
+	\param	state
+		State of the generator
+
+	\date	19.10.26
+*******************************************************************************/
+static inline unsigned long long nextBits(unsigned long long *state) {
+	unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void makeLevel(struct level *l);
+int startLevelMaker(struct levelMaker *m, int w, int h);
+void prepareLevel(struct levelMaker *m, int number, int robots, unsigned long long seed);
+void takeLevel(struct levelMaker *m, int number, int robots, unsigned long long seed, struct board *board, int *heroX, int *heroY);
+void stopLevelMaker(struct levelMaker *m);
+
+#endif
@@ -1,18 +1,102 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
 #include <dirent.h>
 
 #include <sys/time.h>
 #include <time.h>
 
-#include "SDL/SDL.h"
-#include "SDL/SDL_ttf.h"
-#include "SDL/SDL_image.h"
+#include "sdl.h"
 #include "defs.h"
+#include "pipeline.h"
+#include "bands.h"
+#include "board.h"
+#include "camera.h"
+#include "bot.h"
+#include "replay.h"
+#include "capture.h"
+#include "level.h"
+#include "assets.h"
+#include "render.h"
+#include "scale.h"
+#include "danger.h"
+#include "rules.h"
+#include "advisor.h"
+#include "pool.h"
+#include "solver.h"
+#include "cache.h"
+#include "stepper.h"
+#include "scores.h"
+#include "rewind.h"
+#include "spectator.h"
+#include "snapshot.h"
+
+SDL_Surface *screen;
+SDL_Surface *sprites;
+SDL_Surface *robot;
+SDL_Surface *hero;
+SDL_Surface *trash;
+
+SDL_Color white = { 0xFF, 0xFF, 0xFF, 0 };
+SDL_Color black = { 0x00, 0x00, 0x00, 0 };
+SDL_Color *forecol;
+SDL_Color *backcol;	
+	
+SDL_Rect dstrect, srcrect;
+
+TTF_Font *font;
+	
+struct board playfield;
+int robotCount, currentLevel, HERO_X, HERO_Y,  updateMovement, HERO_MOVEMENT, safeTeleports, robotsKilled;
+int dangerOverlay;
+unsigned int animationTime;
+
+static unsigned long long randomState = 1;
+static unsigned long long gameSeed;
+static struct levelMaker levels;
+static unsigned int randomSeed;
+static int virtualClock;
+static unsigned int virtualTime, logicStart;
+static const char *capturePath, *replayPath, *recordPath, *assetPath, *rendererName, *cachePath;
+static struct levelCache levelCache;
+static int generateCount;
+static const char *scorePath;
+static const char *scoreQuery;
+static struct scoreStore scores;
+static int captureFps = CAPTURE_FPS;
+static int windowScale = 1;
+static struct journal playfieldJournal;
+static struct explosions explosions;
+static struct dangerMap danger;
+static struct advisor advisor;
+static struct stepper stepper;
+static struct rewindBuffer rewindBuffer;
+static struct spectator spectator;
+static int spectateCount;
+static const char *snapshotPath;
+static struct snapshot resumed;
+static unsigned int advisedSerial;
+static int advising;
+static unsigned int advisedTurns;
+static int shownRollouts;
+static unsigned int adviceTime;
+
+/*
+	Tints of the danger overlay, for cells a robot reaches in 1, 2 and 3 moves
+*/
+static const struct {
+	Uint32 colour;
+	int alpha;
+} dangerTints[] = {
+	{ 0xFF0000, 112 },
+	{ 0xFF8000, 80 },
+	{ 0xFFFF00, 56 },
+};
 
-void insertPersonsToField(void);
+unsigned long long randomBits(void);
+void saveGame(void);
 
 /*!*****************************************************************************
 	\brief List of different display states (aka gamestates)	
@@ -115,57 +199,63 @@ void initRectangle(SDL_Rect *rect, int x, int y, int w, int h) {
 	\author	Lari Koskinen
 *******************************************************************************/
 int drawTTFText(int x, int y, int w, char *text, unsigned int colour) {
-	SDL_Surface *rendText;
-	SDL_Rect rect, src;
-	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF)};
-	int middleX, middleY;
-
-	if((screen != NULL) && (font != NULL) && (text != NULL)) {
-		if((rendText = TTF_RenderText_Solid(font, text, color)) != NULL) {
-			initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
-			middleX = ((FIELD_X * FIELD_WIDTH) / 2) - (rendText->w / 2);
-			middleY = ((FIELD_Y * FIELD_WIDTH) / 2) - (rendText->h / 2);
-			initRectangle(&rect, ((!x)? middleX: x), ((!y)? middleY: y), ((!w)? rendText->w: w), rendText->h);
-			SDL_BlitSurface(rendText, &src, screen, &rect);
-			SDL_FreeSurface(rendText);
-			return 0;
-		}
-	}
-	return -1;
+	return renderer->text(x, y, w, text, colour);
 }
 
 /*!*****************************************************************************
 	\brief	Draw menu text on screen 	
 
-	\param	txt
-		Enum-state of the menu text
+	\param	f
+		Frame with the enum-state of the menu text
 
 	\date	7.1.18
 
 	\author	Lari Koskinen
 *******************************************************************************/
-int drawText(int txt) {
+int drawText(const struct frame *f) {
 	char textInfo[1024];
 
-	gamestate = MENU_STATE;
-	SDL_FillRect(screen, NULL, 0xFFFFFF);
-	switch(txt) {
+	renderer->fill(NULL, 0xFFFFFF);
+	switch(f->text) {
 		case GAME_OVER:
 			return drawTTFText(0, 0, 0, "GAME OVER", 0xFF00FF); 
 		case TITLE:
-			drawTTFText(0, 100, 0, "R.O.B.O.T.S.", 0xFF00FF); 
-			drawTTFText(0, 200, 0, "Use numpad to move", 0xFF00FF); 
-			drawTTFText(0, 250, 0, "5 to wait", 0xFF00FF); 
-			drawTTFText(0, 300, 0, "0 to teleport", 0xFF00FF); 
-			drawTTFText(0, 350, 0, "Left corner displays safe teleports", 0xFF00FF); 
-			return drawTTFText(0, 450, 0, "Press space to start", 0xFF00FF); 
+			drawTTFText(0, 100 * windowScale, 0, "R.O.B.O.T.S.", 0xFF00FF); 
+			drawTTFText(0, 200 * windowScale, 0, "Use numpad to move", 0xFF00FF); 
+			drawTTFText(0, 250 * windowScale, 0, "5 to wait", 0xFF00FF); 
+			drawTTFText(0, 300 * windowScale, 0, "0 to teleport", 0xFF00FF); 
+			drawTTFText(0, 350 * windowScale, 0, "Left corner displays safe teleports", 0xFF00FF); 
+			if(f->scores.count) {
+				sprintf(textInfo, "Best %d robots on level %d of %d games", f->scores.best[0].killed, f->scores.best[0].level, f->scores.games);
+				drawTTFText(0, 400 * windowScale, 0, textInfo, 0xFF00FF);
+			}
+			return drawTTFText(0, 450 * windowScale, 0, "Press space to start", 0xFF00FF); 
 		case LEVEL:
-			sprintf(textInfo, "ENTERING LEVEL %d", currentLevel);
+			sprintf(textInfo, "ENTERING LEVEL %d", f->currentLevel);
 			return drawTTFText(0, 0, 0, textInfo, 0xFF00FF); 
 	}
 	return -1;
 };
 
+/*!*****************************************************************************
+	\brief	Show menu text and wait in the menu state
+
+	\param	txt
+		Enum-state of the menu text
+
+	\date	19.10.26
+*******************************************************************************/
+void showText(int txt) {
+	struct frame *f = backFrame(&frames);
+
+	gamestate = MENU_STATE;
+	f->screen = SCREEN_TEXT;
+	f->text = txt;
+	f->currentLevel = currentLevel;
+	f->scores = scores.summary;
+	publishBackFrame(&frames);
+}
+
 /*!*****************************************************************************
 	\brief  Free all reserved resources	
 
@@ -174,13 +264,24 @@ int drawText(int txt) {
 	\author	Lari Koskinen
 *******************************************************************************/
 void quit() {
+	closeCapture();
+	closeRecording();
+	closeReplay();
+	stopLevelMaker(&levels);
+	stopAdvisor(&advisor);
+	stopStepper(&stepper);
+	stopSpectator(&spectator);
+	freeExplosions(&explosions);
+	closeScores(&scores);
+	freeBands();
 	SDL_FreeSurface(sprites);
 	SDL_FreeSurface(robot);
 	SDL_FreeSurface(hero);
 	SDL_FreeSurface(trash);
-	SDL_FreeSurface(screen);
+	renderer->close();
 	SDL_Quit();
 	TTF_Quit();
+	closeAssets();
 	exit(1);
 }
 
@@ -270,39 +371,6 @@ int getHeroImage(SDL_Rect *rect, int image) {
 	if(image > HERO_WAVE_LEFT) {
 		return -1;
 	}
-	if(!updateMovement) {
-		switch(image) {
-			case HERO_MOVE_LEFT:
-			case HERO_WAVE_LEFT:
-				image = HERO_LEFT;
-			break;
-			case HERO_MOVE_RIGHT:
-			case HERO_WAVE_RIGHT:
-				image = HERO_RIGHT;
-			break;
-			case HERO_MOVE_DOWN_1:
-			case HERO_MOVE_DOWN_2:
-			case HERO_WAVE_DOWN:
-				image = HERO_PONDERING;
-			break;
-			case HERO_RIGHT:
-				image = HERO_WAVE_RIGHT;
-			break;
-			case HERO_LEFT:
-				image = HERO_WAVE_LEFT;
-			break;
-			case HERO_PONDERING:
-				image = HERO_DOWN;
-			break;
-			case HERO_DOWN:
-				image = HERO_WAVE_DOWN;
-			break;
-			case HERO_TELEPORT:
-				image = HERO_DOWN;
-			break;
-		}
-		HERO_MOVEMENT = image;
-	}
 
 	rect->x = image * FIELD_WIDTH;
 	rect->y = 0;
@@ -311,6 +379,34 @@ int getHeroImage(SDL_Rect *rect, int image) {
 	return 0;
 }
 
+/*!*****************************************************************************
+	\brief	Convert a loaded image to the pixel format of the screen
+
+	An image already in the format of the screen is kept as it is.
+
+	\param	surface
+		Surface to be converted, replaced with the converted one
+
+	\date	19.10.26
+*******************************************************************************/
+int toDisplayFormat(SDL_Surface **surface) {
+	SDL_Surface *converted;
+	const SDL_PixelFormat *from = (*surface)->format, *to = screen->format;
+
+	if((from->BitsPerPixel == to->BitsPerPixel) && (from->Rmask == to->Rmask) &&
+		(from->Gmask == to->Gmask) && (from->Bmask == to->Bmask)) {
+		return 0;
+	}
+
+	if((converted = SDL_ConvertSurface(*surface, screen->format, SDL_SWSURFACE)) == NULL) {
+		fprintf(stderr, "Couldn't convert image: %s\n", SDL_GetError());
+		return -1;
+	}
+	SDL_FreeSurface(*surface);
+	*surface = converted;
+	return 0;
+}
+
 /*!*****************************************************************************
 	\brief	Load all game bitmaps to SDL-image surfaces for later use
 
@@ -319,9 +415,10 @@ int getHeroImage(SDL_Rect *rect, int image) {
 	\author	Lari Koskinen
 *******************************************************************************/
 int createSurfaces(void) {
+	SDL_Surface *sheets[SHEETS];
+
 	
 	// Initialize SDL 
-	char basepath[1024], path[1024];
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
 		fprintf(stderr, "Couldn't initialize SDL: %s\n",SDL_GetError());
 		return(2);
@@ -329,42 +426,62 @@ int createSurfaces(void) {
 	// Hide cursor
 	SDL_ShowCursor(SDL_DISABLE);
 	
-	// Load image
-	if(getcwd(basepath, 1024) != NULL) {
-		sprintf(path, "%s/%s", basepath, "evil.bmp");
-		if((robot = IMG_Load(path)) == NULL) {
-			fprintf(stderr, "Couldn't load image: %s\n", SDL_GetError());
-			return -1;
-		}
-	
-		sprintf(path, "%s/%s", basepath, "hero.bmp");
-		if((hero = IMG_Load(path)) == NULL) {
-			fprintf(stderr, "Couldn't load image: %s\n", SDL_GetError());
-			return -1;
-		}
-
-		sprintf(path, "%s/%s", basepath, "scrapheap.bmp");
-		if((trash = IMG_Load(path)) == NULL) {
-			fprintf(stderr, "Couldn't load image: %s\n", SDL_GetError());
-			return -1;
-		}
+	// Sprites are used straight from the asset blob, nothing is decoded
+	if(((robot = loadSprite("evil")) == NULL) || ((hero = loadSprite("hero")) == NULL) || ((trash = loadSprite("scrapheap")) == NULL)) {
+		fprintf(stderr, "Couldn't load image: %s\n", SDL_GetError());
+		return -1;
+	}
 
-		/* Set a 800x600x16 video mode  16x12 */
-		if((screen = SDL_SetVideoMode(FIELD_X * FIELD_WIDTH, FIELD_Y * FIELD_WIDTH, 16, SDL_SWSURFACE)) == NULL) {
-			fprintf(stderr, "Couldn't set 640x480x16 video mode: %s\n", SDL_GetError());
-			return -1;
-		}
-		robotCount = ROBOCOUNT;
-		currentLevel = 0;
+	if(openRenderer(rendererName, camera.w, camera.h, "R.O.B.O.T.S.")) {
+		return -1;
+	}
+	if(toDisplayFormat(&robot) || toDisplayFormat(&hero) || toDisplayFormat(&trash)) {
+		return -1;
+	}
+	sheets[SHEET_ROBOT] = robot;
+	sheets[SHEET_HERO] = hero;
+	sheets[SHEET_TRASH] = trash;
+	if(renderer->load(sheets)) {
+		fprintf(stderr, "Couldn't load sprites for %s: %s\n", renderer->name, SDL_GetError());
+		return -1;
+	}
+	robotCount = firstRobotCount();
+	currentLevel = 0;
 
-		sprintf(path, "%s/%s", basepath, "arial.ttf");
-		if(!(font = TTF_OpenFont(path, 40))) {
-			fprintf(stderr, "Font load error %s\n", TTF_GetError());
-			return -1;
-		}
-		return 0;
+	if(!(font = loadFont("arial", 40 * windowScale))) {
+		fprintf(stderr, "Font load error %s\n", TTF_GetError());
+		return -1;
 	}
-	return -1;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get the amount of robots on the first level
+
+	ROBOCOUNT is for a field of FIELD_X x FIELD_Y, bigger fields get more.
+
+	\date	19.10.26
+*******************************************************************************/
+int firstRobotCount(void) {
+	long long count = (long long)ROBOCOUNT * playfield.w * playfield.h / (FIELD_X * FIELD_Y);
+	return (count < 1)? 1: (int)count;
+}
+
+/*!*****************************************************************************
+	\brief	Get the amount of robots on the level after a level
+
+	\param	robots
+		Robots on the current level
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+int nextRobotCount(int robots) {
+	float calculate = (float)robots;
+	calculate = calculate * 1.2;
+	robots = (int)calculate;
+	return (robots >= (playfield.w * playfield.h))? robots - 8: robots;
 }
 
 /*!*****************************************************************************
@@ -375,13 +492,72 @@ int createSurfaces(void) {
 	\author	Lari Koskinen
 *******************************************************************************/
 void nextLevel(void) {
-	float calculate = (float)robotCount;
-	calculate = calculate * 1.2;
-	robotCount = (int)calculate;
-	robotCount = (robotCount >= (FIELD_X * FIELD_Y))? robotCount - 8: robotCount;
+	robotCount = nextRobotCount(robotCount);
 	safeTeleports+=2;
 }
 
+/*!*****************************************************************************
+	\brief	Get the seed a level is made from
+
+	A level found in the level cache is one of its verified seeds, picked by
+	the seed of the game. Any other level is made from the game seed.
+
+	\param	number
+		Number of the level
+
+	\param	robots
+		Amount of robots on the level
+
+	\date	19.10.26
+*******************************************************************************/
+unsigned long long levelSeed(int number, int robots) {
+	const struct cacheEntry *entry = findCachedLevel(&levelCache, playfield.w, playfield.h, number);
+
+	if((entry == NULL) || (entry->robots != robots) || !entry->variants) {
+		return gameSeed;
+	}
+	return entry->seed[gameSeed % (unsigned long long)entry->variants];
+}
+
+/*!*****************************************************************************
+	\brief	Search levels solvable without teleports and store them in the cache
+
+	\param	count
+		Levels to search, from the first one on
+
+	\return	0 on success, -1 if the cache could not be written
+
+	\date	19.10.26
+*******************************************************************************/
+int generateLevels(int count) {
+	struct cacheEntry entry;
+	struct pool *pool;
+	unsigned long long seeds[CACHE_VARIANTS];
+	int number, robots = firstRobotCount(), i;
+
+	if((pool = createPool(cpuCount() - 1)) == NULL) {
+		fprintf(stderr, "Couldn't start the search threads\n");
+		return -1;
+	}
+	for(number=1; number<=count; number++, robots=nextRobotCount(robots)) {
+		memset(&entry, 0, sizeof(entry));
+		entry.w = playfield.w;
+		entry.h = playfield.h;
+		entry.number = number;
+		entry.robots = robots;
+		entry.variants = findSolvable(pool, number, robots, playfield.w, playfield.h, CACHE_VARIANTS, seeds);
+		for(i=0; i<entry.variants; i++) {
+			entry.seed[i] = seeds[i];
+		}
+		fprintf(stderr, "Level %d with %d robots: %d solvable layouts\n", number, robots, entry.variants);
+		if(entry.variants && storeCachedLevel(&levelCache, &entry)) {
+			break;
+		}
+	}
+	destroyPool(pool);
+	return saveLevelCache(&levelCache, cachePath);
+}
+
 /*!*****************************************************************************
 	\brief	Set pieces on the playfield
 
@@ -390,25 +566,100 @@ void nextLevel(void) {
 	\author	Lari Koskinen
 *******************************************************************************/
 int setPlayfield(void) {	
-	int i, j;
 	if(currentLevel) {
 		nextLevel();
 	}
 	else {
-		robotCount = ROBOCOUNT;
+		robotCount = firstRobotCount();
 	}
 	currentLevel++;
-	for(i=0;i<FIELD_X;i++) {
-		for(j=0;j<FIELD_Y;j++) {
-			playfield[i][j] = EMPTY;
-		}
-	}
-	insertPersonsToField();
+	// Made in the background while the previous level was played
+	takeLevel(&levels, currentLevel, robotCount, levelSeed(currentLevel, robotCount), &playfield, &HERO_X, &HERO_Y);
+	prepareLevel(&levels, currentLevel + 1, nextRobotCount(robotCount), levelSeed(currentLevel + 1, nextRobotCount(robotCount)));
 	if(currentLevel) {
-		drawText(LEVEL);
+		showText(LEVEL);
 		gamestate = LEVEL_TEXT;
 	}
+	// Every level starts with a checkpoint
+	saveGame();
+
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Write the game in progress to the snapshot file, if there is one
+
+	A lost game is taken out of the file as soon as the hero dies, so the
+	level can not be tried again. The game started after it is then
+	checkpointed at its first level like any other game.
+
+	\date	19.10.26
+*******************************************************************************/
+void saveGame(void) {
+	struct snapshotHeader header;
+
+	if(snapshotPath == NULL) {
+		return;
+	}
+	if(gamestate == END_GAME) {
+		if(remove(snapshotPath) && (errno != ENOENT)) {
+			perror(snapshotPath);
+		}
+		return;
+	}
+	if((gamestate != PLAY_STATE) && (gamestate != LEVEL_TEXT) && (gamestate != NEXT_LEVEL)) {
+		return;
+	}
+	memset(&header, 0, sizeof(header));
+	header.heroX = HERO_X;
+	header.heroY = HERO_Y;
+	header.heroImage = HERO_MOVEMENT;
+	header.updateMovement = updateMovement;
+	header.currentLevel = currentLevel;
+	header.robotCount = robotCount;
+	header.safeTeleports = safeTeleports;
+	header.robotsKilled = robotsKilled;
+	header.randomState = randomState;
+	header.gameSeed = gameSeed;
+	header.advisedTurns = advisedTurns;
+	if(saveSnapshot(snapshotPath, &header, &playfield)) {
+		fprintf(stderr, "Game was not saved to %s\n", snapshotPath);
+	}
+}
 
+/*!*****************************************************************************
+	\brief	Go on with the game in the snapshot read at start
+
+	The game starts from the level text, so the player gets a moment
+	before the robots move.
+
+	\return	0 on success, -1 if there is no snapshot
+
+	\date	19.10.26
+*******************************************************************************/
+int resumeGame(void) {
+	const struct snapshotHeader *header = resumed.header;
+
+	if(header == NULL) {
+		return -1;
+	}
+	restoreSnapshot(&resumed, &playfield);
+	HERO_X = header->heroX;
+	HERO_Y = header->heroY;
+	HERO_MOVEMENT = header->heroImage;
+	updateMovement = header->updateMovement;
+	currentLevel = header->currentLevel;
+	robotCount = header->robotCount;
+	safeTeleports = header->safeTeleports;
+	robotsKilled = header->robotsKilled;
+	randomState = header->randomState;
+	gameSeed = header->gameSeed;
+	advisedTurns = header->advisedTurns;
+	closeSnapshot(&resumed);
+	clearRewind(&rewindBuffer);
+	prepareLevel(&levels, currentLevel + 1, nextRobotCount(robotCount), levelSeed(currentLevel + 1, nextRobotCount(robotCount)));
+	showText(LEVEL);
+	gamestate = LEVEL_TEXT;
 	return 0;
 }
 
@@ -424,10 +675,71 @@ int resetPlayfield(void) {
 	currentLevel = 0;
 	robotsKilled = 0;
 	safeTeleports = 4;
+	gameSeed = randomBits();
 	setPlayfield();
 	return 0;
 }
 
+/*!*****************************************************************************
+	\brief	Append the result of the game that ended to the score log
+
+	\date	19.10.26
+*******************************************************************************/
+void saveScore(void) {
+	struct scoreRecord record;
+
+	if(scorePath == NULL) {
+		return;
+	}
+	memset(&record, 0, sizeof(record));
+	record.seed = gameSeed;
+	record.w = playfield.w;
+	record.h = playfield.h;
+	record.level = currentLevel;
+	record.killed = robotsKilled;
+	record.policy = (replayPath != NULL)? POLICY_REPLAY: (capturePath != NULL)? POLICY_BOT: POLICY_HUMAN;
+	if(addScore(&scores, &record)) {
+		fprintf(stderr, "Score of the game was not saved\n");
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Print the answer to a score query and close the score log
+
+	\param	query
+		top, a policy name for its best games or seed=number for the games
+		played on a seed
+
+	\return	0 on success, -1 on a bad query or a read error
+
+	\date	19.10.26
+*******************************************************************************/
+int printScores(const char *query) {
+	struct scoreRecord found[SCORE_LIST];
+	int count = -1, policy, i;
+
+	if(!strncmp(query, "seed=", 5)) {
+		count = seedScores(&scores, strtoull(query + 5, NULL, 0), SCORE_LIST, found);
+	}
+	else if(!strcmp(query, "top")) {
+		count = topScores(&scores, -1, SCORE_LIST, found);
+	}
+	for(policy=0; (count < 0) && (policy < SCORE_POLICIES); policy++) {
+		if(!strcmp(query, policyName(policy))) {
+			count = topScores(&scores, policy, SCORE_LIST, found);
+		}
+	}
+	if(count < 0) {
+		fprintf(stderr, "Query is top, human, replay, bot or seed=number\n");
+	}
+	for(i=0; i<count; i++) {
+		printf("%6d robots  level %3d  %-6s  %dx%d  seed %llu\n", found[i].killed, found[i].level,
+			policyName(found[i].policy), found[i].w, found[i].h, (unsigned long long)found[i].seed);
+	}
+	closeScores(&scores);
+	return (count < 0)? -1: 0;
+}
+
 /*!*****************************************************************************
 	\brief	Display game over
 
@@ -436,9 +748,10 @@ int resetPlayfield(void) {
 	\author	Lari Koskinen
 *******************************************************************************/
 void endGame(void) {
+	saveScore();
 	currentLevel = 0;
 	resetPlayfield();
-	drawText(GAME_OVER);
+	showText(GAME_OVER);
 }
 
 /*!*****************************************************************************
@@ -461,13 +774,15 @@ int drawRobot(int x, int y, int dir) {
 		if(getRobotImage(&srcrect, dir)) {
 			return -1;
 		}
-		dstrect.x = x * FIELD_WIDTH;
-		dstrect.y = y * FIELD_WIDTH;
-		dstrect.w = FIELD_WIDTH;
-		dstrect.h = FIELD_WIDTH;
+		if(!renderer->scales) {
+			spriteRect(&srcrect, camera.cell);
+		}
+		dstrect.x = x * camera.cell - camera.x;
+		dstrect.y = y * camera.cell - camera.y;
+		dstrect.w = camera.cell;
+		dstrect.h = camera.cell;
 			
-		// Blit sprite to surface
-		SDL_BlitSurface(robot, &srcrect, screen, &dstrect);
+		renderer->sprite(SHEET_ROBOT, &srcrect, &dstrect);
 	}
 	return 0;
 }
@@ -493,13 +808,15 @@ int drawTrash(int x, int y, int state) {
 		srcrect.y = 0;
 		srcrect.w = FIELD_WIDTH;
 		srcrect.h = FIELD_WIDTH;
-		dstrect.x = x * FIELD_WIDTH;
-		dstrect.y = y * FIELD_WIDTH;
-		dstrect.w = FIELD_WIDTH;
-		dstrect.h = FIELD_WIDTH;
+		if(!renderer->scales) {
+			spriteRect(&srcrect, camera.cell);
+		}
+		dstrect.x = x * camera.cell - camera.x;
+		dstrect.y = y * camera.cell - camera.y;
+		dstrect.w = camera.cell;
+		dstrect.h = camera.cell;
 			
-		// Blit sprite to surface
-		SDL_BlitSurface(trash, &srcrect, screen, &dstrect);
+		renderer->sprite(SHEET_TRASH, &srcrect, &dstrect);
 	}
 	return 0;
 }
@@ -507,6 +824,9 @@ int drawTrash(int x, int y, int state) {
 /*!*****************************************************************************
 	\brief	Get direction to move the robot from given position towards the hero
 
+	\param	f
+		Frame being drawn
+
 	\param	x, y
 		Position from where to calculate the position, the robot should face
 
@@ -514,22 +834,22 @@ int drawTrash(int x, int y, int state) {
 
 	\author	Lari Koskinen
 *******************************************************************************/
-int getDirection(int x, int y) {
+int getDirection(const struct frame *f, int x, int y) {
 	int dir = 0;
 
-	if(updateMovement) {
-		if(x < HERO_X) {
+	if(f->updateMovement) {
+		if(x < f->heroX) {
 			dir = ROBOT_MOVE_RIGHT;
 		}
-		else if(x > HERO_X) {
+		else if(x > f->heroX) {
 			dir = ROBOT_MOVE_LEFT;
 		}
 	}
 	else {
-		if(x < HERO_X) {
+		if(x < f->heroX) {
 			dir = ROBOT_STAND_RIGHT;
 		}
-		else if(x > HERO_X) {
+		else if(x > f->heroX) {
 			dir = ROBOT_STAND_LEFT;
 		}
 	}
@@ -540,24 +860,29 @@ int getDirection(int x, int y) {
 /*!*****************************************************************************
 	\brief	Draw the hero
 
+	\param	f
+		Frame being drawn
+
 	\date	7.1.18
 
 	\author	Lari Koskinen
 *******************************************************************************/
-int drawProgtagonist(void) {
+int drawProgtagonist(const struct frame *f) {
 	SDL_Rect dstrect, srcrect;
 
 	if(hero != NULL) {
-		if(getHeroImage(&srcrect, HERO_MOVEMENT)) {
+		if(getHeroImage(&srcrect, f->heroImage)) {
 			return -1;
 		}
-		dstrect.x = HERO_X * FIELD_WIDTH;
-		dstrect.y = HERO_Y * FIELD_WIDTH;
-		dstrect.w = FIELD_WIDTH;
-		dstrect.h = FIELD_WIDTH;
+		if(!renderer->scales) {
+			spriteRect(&srcrect, camera.cell);
+		}
+		dstrect.x = f->heroX * camera.cell - camera.x;
+		dstrect.y = f->heroY * camera.cell - camera.y;
+		dstrect.w = camera.cell;
+		dstrect.h = camera.cell;
 			
-		// Blit sprite to surface
-		SDL_BlitSurface(hero, &srcrect, screen, &dstrect);
+		renderer->sprite(SHEET_HERO, &srcrect, &dstrect);
 	}
 	return 0;
 }
@@ -565,234 +890,410 @@ int drawProgtagonist(void) {
 /*!*****************************************************************************
 	\brief	Fill the field with robots
 
+	\param	f
+		Frame being drawn
+
 	\date	7.1.18
 
 	\author	Lari Koskinen
 *******************************************************************************/
-void drawRobots(void) {
-	int x, y, item, dir;
-	char textInfo[2014];
-	for(x=0; x<FIELD_X; x++) {
-		for(y=0;y<FIELD_Y; y++) {
-			if((item = playfield[x][y]) != EMPTY) {
+void drawRobots(const struct frame *f) {
+	int x, y, item, dir, x0, y0, x1, y1;
+	if(visibleCells(&camera, &f->playfield, 0, screen->h, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	for(x=x0; x<=x1; x++) {
+		for(y=y0;y<=y1; y++) {
+			if(!CHUNK(&f->playfield, x >> CHUNK_SHIFT, y >> CHUNK_SHIFT)) {
+				y |= CHUNK_SIZE - 1;
+				continue;
+			}
+			if((item = CELL(&f->playfield, x, y)) != EMPTY) {
 				switch(item) {
 					case HERO_EXPLOSION:
 						drawTrash(x, y, 2);
-						playfield[x][y] = EXPLOSION;
 					break;
 					case EXPLOSION:
 						drawTrash(x, y, 1);
-						playfield[x][y] = TRASH;
 					break;
 					case TRASH:
 						drawTrash(x, y, 0);
 					break;
 					case ROBOT:
-						dir = getDirection(x, y);
+						dir = getDirection(f, x, y);
 						drawRobot(x, y, dir);
 					break;
 					case HERO:
-						drawProgtagonist();
+						drawProgtagonist(f);
 					break;
 				};
 			}
 		}
 	}
-	sprintf(textInfo, "%d", safeTeleports);
-	drawTTFText(1, 1, 0, textInfo, 0x0000FF);
-	updateMovement = 0;
 }
 
 /*!*****************************************************************************
-	\brief	Move all robots towards the hero
+	\brief	Get the tint the danger overlay puts on a cell
 
-	\date	7.1.18
+	\param	f
+		Frame being drawn
 
-	\author	Lari Koskinen
+	\param	x, y
+		Position of the cell on the field
+
+	\return	Moves a robot needs to reach the cell, 0 if the cell is not tinted
+
+	\date	19.10.26
 *******************************************************************************/
-int moveRobots(void) {
-	int x = HERO_X, y = HERO_Y, move_x, move_y;
-
-	for(;y<FIELD_Y;y++) {
-		for(;x<FIELD_X;x++) {
-			if(playfield[x][y] == ROBOT) {
-				playfield[x][y] = EMPTY;
-				move_x = (x < HERO_X)? x+1: (x > HERO_X)? x-1: x;
-				move_y = (y < HERO_Y)? y+1: (y > HERO_Y)? y-1: y;
-				if(playfield[move_x][move_y] == HERO) {
-					playfield[move_x][move_y] = HERO_EXPLOSION; //TRASH;
-					gamestate = END_GAME;
-					drawEverything();
-					return 1;
-				}
-				else if(playfield[move_x][move_y] != EMPTY) {
-					if(playfield[move_x][move_y] == MOVED_ROBOT) {
-						robotsKilled+=2;
-					}
-					else {
-						robotsKilled++;
-					}
-					playfield[move_x][move_y] = EXPLOSION; //TRASH;
-				}
-				else {
-					playfield[move_x][move_y] = MOVED_ROBOT;
-				}
-			}
-		}
-		x = 0;
-	}
-
-	x = HERO_X;
-	y = HERO_Y;
-	for(;y>=0;y--) {
-		for(;x>=0;x--) {
-			if(playfield[x][y] == ROBOT) {
-				move_x = (x < HERO_X)? x+1: (x > HERO_X)? x-1: x;
-				move_y = (y < HERO_Y)? y+1: (y > HERO_Y)? y-1: y;
-				if(playfield[move_x][move_y] == HERO) {
-					playfield[move_x][move_y] = HERO_EXPLOSION; //TRASH;
-					gamestate = END_GAME;
-					drawEverything();
-					return 1;
-				}
-				else if(playfield[move_x][move_y] != EMPTY) {
-					if(playfield[move_x][move_y] == MOVED_ROBOT) {
-						robotsKilled+=2;
-					}
-					else {
-						robotsKilled++;
-					}
-					playfield[x][y] = EMPTY;
-					playfield[move_x][move_y] = EXPLOSION; //TRASH;
-				}
-				else
-				{
-					playfield[x][y] = EMPTY;
-					playfield[move_x][move_y] = MOVED_ROBOT;
-				}
-			}
-		}
-		x = FIELD_X - 1;
+int dangerShade(const struct frame *f, int x, int y) {
+	int distance;
+
+	if(!dangerOverlay) {
+		return 0;
 	}
-	for(x=0;x<FIELD_X;x++) {
-		for(y=0;y<FIELD_Y;y++) {
-			if(playfield[x][y] == MOVED_ROBOT) {
-				playfield[x][y] = ROBOT;
-			}
-			else if(playfield[x][y] == ROBOT) {
-				printf("What? An unmoved robot?\n");
-			}
-		}
+	distance = f->danger[y * f->playfield.w + x];
+	return (distance <= (int)(sizeof(dangerTints) / sizeof(*dangerTints)))? distance: 0;
+}
+
+/*!*****************************************************************************
+	\brief	Tint a cell by how soon a robot can reach it
+
+	\param	f
+		Frame being drawn
+
+	\param	x, y
+		Position of the cell on the field
+
+	\date	19.10.26
+*******************************************************************************/
+void drawDanger(const struct frame *f, int x, int y) {
+	SDL_Rect rect;
+	int shade;
+
+	if((shade = dangerShade(f, x, y)) != 0) {
+		initRectangle(&rect, x * camera.cell - camera.x, y * camera.cell - camera.y, camera.cell, camera.cell);
+		renderer->tint(&rect, dangerTints[shade - 1].colour, dangerTints[shade - 1].alpha);
 	}
-	updateMovement = 1;
-	return 0;
 }
 
 /*!*****************************************************************************
-	\brief	Get amount of active robots on field
+	\brief	Draw the danger overlay over the visible field
 
-	\date	7.1.18
+	\param	f
+		Frame being drawn
 
-	\author	Lari Koskinen
+	\date	19.10.26
 *******************************************************************************/
-int getRobotCount(void) {
-	int x,y, count=0;
-	for(x=0;x<FIELD_X;x++) {
-		for(y=0;y<FIELD_Y;y++) {
-			if(playfield[x][y] == ROBOT) {
-				count++;
-			}
+void drawDangers(const struct frame *f) {
+	int x, y, x0, y0, x1, y1;
+
+	if(!dangerOverlay || visibleCells(&camera, &f->playfield, 0, screen->h, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	for(y=y0; y<=y1; y++) {
+		for(x=x0; x<=x1; x++) {
+			drawDanger(f, x, y);
 		}
 	}
-	return count;
 }
 
 /*!*****************************************************************************
-	\brief	Get current time in milliseconds
+	\brief	Write the text of the HUD
 
-	\date	7.1.18
+	The amount of safe teleports, followed by the survival odds of the
+	teleport and of the best step once the advisor has played some games.
 
-	\author	Lari Koskinen
+	\param	f
+		Frame being drawn
+
+	\param	text
+		Buffer of at least 64 characters
+
+	\date	19.10.26
 *******************************************************************************/
-unsigned long long TickCount(void) {
-	unsigned long long dw = 0;
+void hudText(const struct frame *f, char *text) {
+	int i, best = 0;
 
-	struct timeval tvnow;
-	unsigned long long s,us;
+	if(!f->advice.rollouts) {
+		sprintf(text, "%d", f->safeTeleports);
+		return;
+	}
+	for(i=0; i<ADVISOR_MOVES; i++) {
+		if((i != BOT_TELEPORT) && (f->advice.survived[i] > best)) {
+			best = f->advice.survived[i];
+		}
+	}
+	sprintf(text, "%d  T %d%%  S %d%%", f->safeTeleports,
+		f->advice.survived[BOT_TELEPORT] * 100 / f->advice.rollouts, best * 100 / f->advice.rollouts);
+}
 
-	gettimeofday(&tvnow, NULL);
-	s= (unsigned long long)tvnow.tv_sec;
-	us= (unsigned long long)tvnow.tv_usec;
+/*!*****************************************************************************
+	\brief	Draw the amount of safe teleports on top of the field
 
-	dw = (unsigned long long)((s * (unsigned long long)1000) +(us / (unsigned long long)1000));
+	\param	f
+		Frame being drawn
 
-	return (unsigned long long)dw;
+	\date	19.10.26
+*******************************************************************************/
+void drawHud(const struct frame *f) {
+	char textInfo[64];
+
+	hudText(f, textInfo);
+	drawTTFText(1, 1, 0, textInfo, 0x0000FF);
 }
 
 /*!*****************************************************************************
-	\brief	Create a random value according to TickCount
+	\brief	Get the area of the screen drawHud draws to
 
-	\param	max
-		Maximum value of the random number to be created
+	\param	f
+		Frame being drawn
 
-	\date	7.1.18
+	\param	rect
+		Area of the safe teleport counter, empty without a font
 
-	\author	Lari Koskinen
+	\date	19.10.26
 *******************************************************************************/
-long long randomValue(int max) {
-	long long item = 0;
-	static long long next2 = 1;
-	next2 = next2 * 1103515245 + TickCount();
-	item = (((unsigned)(next2/65536) % 32768) % (max));
-	return ((item < 0)? 0: (item > max)? max: item);
+void getHudRect(const struct frame *f, SDL_Rect *rect) {
+	char textInfo[64];
+	int w = 0, h = 0;
+
+	hudText(f, textInfo);
+	if((font == NULL) || TTF_SizeText(font, textInfo, &w, &h)) {
+		w = h = 0;
+	}
+	initRectangle(rect, 1, 1, w, h);
 }
 
 /*!*****************************************************************************
-	\brief	Insert items into field
+	\brief	Get the hero image that follows the given one when standing still
 
-	\date	7.1.18
+	\param	image
+		enum state of the current hero image
 
-	\author	Lari Koskinen
+	\date	19.10.26
 *******************************************************************************/
-void insertPersonsToField(void) {
-	int i, x, y;
-
-	HERO_X = randomValue(FIELD_X-1);
-	HERO_Y = randomValue(FIELD_Y-1);
-	x = HERO_X;
-	y = HERO_Y;
-	playfield[HERO_X][HERO_Y] = HERO;
-	for(i=0; i < robotCount; i++) {
-		while(playfield[x][y] != EMPTY) {
-			x = randomValue(FIELD_X-1);
-			y = randomValue(FIELD_Y-1);
-		}
-		playfield[x][y] = ROBOT;
+int nextHeroImage(int image) {
+	switch(image) {
+		case HERO_MOVE_LEFT:
+		case HERO_WAVE_LEFT:
+			return HERO_LEFT;
+		case HERO_MOVE_RIGHT:
+		case HERO_WAVE_RIGHT:
+			return HERO_RIGHT;
+		case HERO_MOVE_DOWN_1:
+		case HERO_MOVE_DOWN_2:
+		case HERO_WAVE_DOWN:
+			return HERO_PONDERING;
+		case HERO_RIGHT:
+			return HERO_WAVE_RIGHT;
+		case HERO_LEFT:
+			return HERO_WAVE_LEFT;
+		case HERO_PONDERING:
+			return HERO_DOWN;
+		case HERO_DOWN:
+			return HERO_WAVE_DOWN;
+		case HERO_TELEPORT:
+			return HERO_DOWN;
 	}
+	return image;
 }
 
 /*!*****************************************************************************
-	\brief	Move hero on the field
+	\brief	Start a new animation step for a game turn
 
-	\param	keyPressed
-		SDL keyboard value handler
+	Explosions of the previous turn decay before the turn makes new ones, and
+	the step timer restarts so the result of the turn is shown for a full step.
 
-	\date	7.1.18
+	\param	now
+		Current time in milliseconds
 
-	\author	Lari Koskinen
+	\date	19.10.26
 *******************************************************************************/
-int moveProgtagonist(SDLKey keyPressed) {
-	int x = HERO_X, y = HERO_Y;
-	switch(keyPressed) {
+void animateTurn(unsigned int now) {
+	decayExplosions(&explosions, &playfield);
+	animationTime = now;
+}
+
+/*!*****************************************************************************
+	\brief	Advance the animation timeline
+
+	All sprite state changes happen here and not in the drawing functions, so
+	a frame can be skipped or drawn again without changing the game.
+
+	\param	now
+		Current time in milliseconds
+
+	\return	1 if the animation advanced and the screen should be updated
+
+	\date	19.10.26
+*******************************************************************************/
+int animate(unsigned int now) {
+	int current;
+
+	if((now - animationTime) < ANIMATION_STEP) {
+		return 0;
+	}
+	animationTime = now;
+	// Decay moves no robot, so the advisor goes on with the same turn
+	current = advising && (advisedSerial == playfieldJournal.serial);
+	decayExplosions(&explosions, &playfield);
+	if(current) {
+		advisedSerial = playfieldJournal.serial;
+	}
+	updateMovement = 0;
+	HERO_MOVEMENT = nextHeroImage(HERO_MOVEMENT);
+	return 1;
+}
+
+/*!*****************************************************************************
+	\brief	Tell if the advisor has played more games since the field was shown
+
+	Looked at every ADVISOR_POLL milliseconds until all the games of the
+	turn are played, so the odds on the HUD grow while the player thinks.
+
+	\param	now
+		Current time in milliseconds
+
+	\return	1 if the field should be shown again
+
+	\date	19.10.26
+*******************************************************************************/
+int adviceGrew(unsigned int now) {
+	struct advice advice;
+
+	if(!advising || (shownRollouts >= ADVISOR_ROLLOUTS) || ((now - adviceTime) < ADVISOR_POLL)) {
+		return 0;
+	}
+	adviceTime = now;
+	takeAdvice(&advisor, &advice);
+	return advice.rollouts > shownRollouts;
+}
+
+/*!*****************************************************************************
+	\brief	Move all robots towards the hero
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+int moveRobots(void) {
+	if(stepTiles(&stepper, &playfield, HERO_X, HERO_Y, &robotsKilled)) {
+		gamestate = END_GAME;
+		saveGame();
+		showPlayfield();
+		return 1;
+	}
+	updateMovement = 1;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get amount of active robots on field
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+int getRobotCount(void) {
+	return countRobots(&playfield);
+}
+
+/*!*****************************************************************************
+	\brief	Get current time in milliseconds
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+unsigned long long TickCount(void) {
+	unsigned long long dw = 0;
+
+	struct timeval tvnow;
+	unsigned long long s,us;
+
+	gettimeofday(&tvnow, NULL);
+	s= (unsigned long long)tvnow.tv_sec;
+	us= (unsigned long long)tvnow.tv_usec;
+
+	dw = (unsigned long long)((s * (unsigned long long)1000) +(us / (unsigned long long)1000));
+
+	return (unsigned long long)dw;
+}
+
+/*!*****************************************************************************
+	\brief	Get the milliseconds the game logic runs by
+
+	When capturing, the logic runs on a virtual clock that steps one
+	millisecond per loop, so the game plays as fast as it can be drawn.
+
+	\date	19.10.26
+*******************************************************************************/
+unsigned int gameTicks(void) {
+	return virtualClock? virtualTime: SDL_GetTicks();
+}
+
+/*!*****************************************************************************
+	\brief	Start the random values from a seed, same seed gives the same game
+
+	\param	seed
+		Seed of the random values
+
+	\date	19.10.26
+*******************************************************************************/
+void seedRandom(unsigned int seed) {
+	randomSeed = seed;
+	randomState = seed;
+}
+
+/*!*****************************************************************************
+	\brief	Step the seeded generator and get all of its bits
+
+	\date	19.10.26
+*******************************************************************************/
+unsigned long long randomBits(void) {
+	randomState = randomState * 6364136223846793005ULL + 1442695040888963407ULL;
+	return randomState;
+}
+
+/*!*****************************************************************************
+	\brief	Create a random value from the seeded generator
+
+	\param	max
+		Maximum value of the random number to be created
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+long long randomValue(int max) {
+	long long item = 0;
+	item = (long long)((randomBits() >> 33) % (unsigned)max);
+	return ((item < 0)? 0: (item > max)? max: item);
+}
+
+/*!*****************************************************************************
+	\brief	Move hero on the field
+
+	\param	keyPressed
+		SDL keyboard value handler
+
+	\date	7.1.18
+
+	\author	Lari Koskinen
+*******************************************************************************/
+int moveProgtagonist(SDLKey keyPressed) {
+	struct rewindState before = { HERO_X, HERO_Y, HERO_MOVEMENT, robotsKilled, safeTeleports };
+	int x = HERO_X, y = HERO_Y, teleport = 0;
+	switch(keyPressed) {
 		case SDLK_KP0:
 			while((x == HERO_X) && (y == HERO_Y)) {
-				while(playfield[x][y] != EMPTY) {
-					x = randomValue(FIELD_X-1);
-					y = randomValue(FIELD_Y-1);
+				while(CELL(&playfield, x, y) != EMPTY) {
+					x = randomValue(playfield.w-1);
+					y = randomValue(playfield.h-1);
 				}
 			}
 			HERO_MOVEMENT = HERO_TELEPORT;
-			updateMovement--;
+			teleport = 1;
 		break;
 		case SDLK_KP1:
 			x--;
@@ -839,32 +1340,34 @@ int moveProgtagonist(SDLKey keyPressed) {
 			HERO_MOVEMENT = HERO_MOVE_RIGHT;
 		break;
 		case SDLK_ESCAPE:
-			quit();
+			stopPipeline();
 			return -1;
 		break;
 		default:
 		return -1;
 	};
-	updateMovement++;
-	playfield[HERO_X][HERO_Y] = EMPTY;
-	HERO_X = (x < FIELD_X)? (x >= 0)? x: 0: (FIELD_X - 1);
-	HERO_Y = (y < FIELD_Y)? (y >= 0)? y: 0: (FIELD_Y - 1);
-	if(playfield[HERO_X][HERO_Y] != EMPTY) {		// Hero collision
-		playfield[HERO_X][HERO_Y] = HERO_EXPLOSION;
+	startTurn(&rewindBuffer, &before);
+	animateTurn(gameTicks());
+	updateMovement = 1;
+	setCell(&playfield, HERO_X, HERO_Y, EMPTY);
+	HERO_X = (x < playfield.w)? (x >= 0)? x: 0: (playfield.w - 1);
+	HERO_Y = (y < playfield.h)? (y >= 0)? y: 0: (playfield.h - 1);
+	if(CELL(&playfield, HERO_X, HERO_Y) != EMPTY) {		// Hero collision
+		setCell(&playfield, HERO_X, HERO_Y, HERO_EXPLOSION);
 		gamestate = END_GAME;
-		drawEverything();
+		saveGame();
+		showPlayfield();
 		return 1;
 	}
-	playfield[HERO_X][HERO_Y] = HERO;
-	if(!updateMovement) {
-		updateMovement++;
+	setCell(&playfield, HERO_X, HERO_Y, HERO);
+	if(teleport) {
 		if(safeTeleports > 0)
 		{
 			safeTeleports--;
-			drawEverything();
+			showPlayfield();
 			return 1;
 		}
-		drawEverything();
+		showPlayfield();
 	}
 	return 0;
 }
@@ -872,17 +1375,87 @@ int moveProgtagonist(SDLKey keyPressed) {
 /*!*****************************************************************************
 	\brief	Update screen graphics
 
+	\param	f
+		Frame to be drawn
+
 	\date	7.1.18
 
 	\author	Lari Koskinen
 *******************************************************************************/
-int drawEverything(void) {
-	SDL_FillRect(screen, NULL, 0xFFFFFF);
-	drawProgtagonist();
-	drawRobots();
+int drawEverything(const struct frame *f) {
+	const struct spriteSet *set;
+
+	if(f->screen == SCREEN_TEXT) {
+		return drawText(f);
+	}
+	followHero(&camera, &f->playfield, f->heroX, f->heroY);
+	if(drawBands(f)) {
+		// Without scaling in the renderer the sprites are drawn from a scaled set
+		if(!renderer->scales && (((set = spriteSet(camera.cell)) == NULL) || renderer->load(set->sheet))) {
+			return -1;
+		}
+		renderer->fill(NULL, 0xFFFFFF);
+		drawProgtagonist(f);
+		drawRobots(f);
+	}
+	drawDangers(f);
+	drawHud(f);
 	return 0;
 }
 
+/*!*****************************************************************************
+	\brief	Bring the danger map up to date with the turns played
+
+	New explosions are taken from the changes before they are kept for
+	rewinding and the journal is cleared.
+
+	\date	19.10.26
+*******************************************************************************/
+void updateDangers(void) {
+	updateDanger(&danger, &playfield);
+	trackExplosions(&explosions, &playfield, &playfieldJournal);
+	keepChanges(&rewindBuffer, &playfieldJournal);
+}
+
+/*!*****************************************************************************
+	\brief	Publish the current state of the playfield for drawing
+
+	\date	19.10.26
+*******************************************************************************/
+void showPlayfield(void) {
+	struct frame *f = backFrame(&frames);
+	int i;
+
+	f->screen = SCREEN_FIELD;
+	f->currentLevel = currentLevel;
+	f->safeTeleports = safeTeleports;
+	f->heroX = HERO_X;
+	f->heroY = HERO_Y;
+	f->heroImage = HERO_MOVEMENT;
+	f->updateMovement = updateMovement;
+	copyBoard(&f->playfield, &playfield);
+	// Every change to the field during play restarts the advisor, seeded by
+	// the turn rather than the serial so it does not depend on the mover
+	if(gamestate != PLAY_STATE) {
+		if(advising) {
+			stopAdvising(&advisor);
+			advising = 0;
+		}
+	}
+	else if(!advising || (advisedSerial != playfieldJournal.serial)) {
+		adviseOn(&advisor, &playfield, HERO_X, HERO_Y, safeTeleports, gameSeed ^ ((unsigned long long)++advisedTurns * 0x9E3779B97F4A7C15ULL));
+		advisedSerial = playfieldJournal.serial;
+		advising = 1;
+	}
+	takeAdvice(&advisor, &f->advice);
+	shownRollouts = f->advice.rollouts;
+	updateDangers();
+	for(i=0; i<playfield.w*playfield.h; i++) {
+		f->danger[i] = (danger.kind[i] != DANGER_FREE)? 0: (danger.distance[i] > 0xFF)? 0xFF: danger.distance[i];
+	}
+	publishBackFrame(&frames);
+}
+
 /*!*****************************************************************************
 	\brief	Initialize SDL surfaces
 
@@ -892,12 +1465,36 @@ int drawEverything(void) {
 *******************************************************************************/
 int init(void) {
 	if(TTF_Init() == -1) {
-		printf("Unable to init TTF\n");
+		fprintf(stderr, "Unable to init TTF\n");
 		return -1;
 	} 
 
+	if(openAssets(assetPath)) {
+		return -1;
+	}
+
 	if(createSurfaces()) {
-		printf("Surface load error?\n");
+		fprintf(stderr, "Surface load error?\n");
+		return -1;
+	}
+
+	if(initBands()) {
+		fprintf(stderr, "Drawing on a single thread\n");
+	}
+
+	if(startLevelMaker(&levels, playfield.w, playfield.h)) {
+		fprintf(stderr, "Not enough memory for a spare field\n");
+		return -1;
+	}
+
+	// A capture plays the advisor games inline, so it stays the same
+	if(startAdvisor(&advisor, playfield.w, playfield.h, capturePath == NULL)) {
+		fprintf(stderr, "Not enough memory for the advisor\n");
+		return -1;
+	}
+
+	if(startStepper(&stepper, playfield.w, playfield.h)) {
+		fprintf(stderr, "Not enough memory for the robot mover\n");
 		return -1;
 	}
 
@@ -906,13 +1503,35 @@ int init(void) {
 	backcol = &black;
 	
 	/* Clear the background to background color */
-	SDL_FillRect(screen, NULL, SDL_MapRGB(screen->format, backcol->r, backcol->g, backcol->b));
-	SDL_WM_SetCaption("R.O.B.O.T.S.", 0);
+	renderer->fill(NULL, (backcol->r << 16) | (backcol->g << 8) | backcol->b);
 
 	return 0;
 	
 }
 
+/*!*****************************************************************************
+	\brief	Take back the latest turn of the level
+
+	\return	0 on success, -1 if there is no turn to take back
+
+	\date	19.10.26
+*******************************************************************************/
+int rewindGame(void) {
+	struct rewindState state;
+
+	if(rewindTurn(&rewindBuffer, &playfield, &state)) {
+		return -1;
+	}
+	HERO_X = state.heroX;
+	HERO_Y = state.heroY;
+	HERO_MOVEMENT = state.heroImage;
+	robotsKilled = state.killed;
+	safeTeleports = state.teleports;
+	updateMovement = 0;
+	showPlayfield();
+	return 0;
+}
+
 /*!*****************************************************************************
 	\brief	Do the main game functions
 
@@ -933,67 +1552,442 @@ void doGameGraphs(SDLKey *keyPressed, int *pressedOnce, int *pollTime) {
 	switch(gamestate) {
 		case PLAY_STATE:
 			if(*pressedOnce == 1) {
-				if(!moveProgtagonist(*keyPressed)) {
+				if(*keyPressed == SDLK_BACKSPACE) {
+					rewindGame();
+				}
+				else if(!moveProgtagonist(*keyPressed)) {
 					if(moveRobots()) {
 						*keyPressed = 0;
-						*pollTime = SDL_GetTicks();
+						*pollTime = gameTicks();
 						return;
 					}
 					if(!getRobotCount()) {
 						gamestate = NEXT_LEVEL;
 					}
-					drawEverything();
+					showPlayfield();
 				}
 				*keyPressed = 0;
-				*pollTime = SDL_GetTicks();
+				*pollTime = gameTicks();
 			} 
-			else if((SDL_GetTicks() - *pollTime) >1000) {	
-				*pollTime = SDL_GetTicks();
-				drawEverything();
+			else if(animate(gameTicks()) || adviceGrew(gameTicks())) {
+				showPlayfield();
 			}
 		break;
 		case MENU_STATE:
 			if(*keyPressed == SDLK_SPACE) {
 				gamestate = PLAY_STATE;
-				drawEverything();
-				*pollTime = SDL_GetTicks();
+				showPlayfield();
+				*pollTime = gameTicks();
+				animationTime = *pollTime;
 			}
 			*keyPressed = 0;
 		break;
 		case LEVEL_TEXT:
-			if((*keyPressed == SDLK_SPACE) || ((SDL_GetTicks() - *pollTime) >1000)) {
+			if((*keyPressed == SDLK_SPACE) || ((gameTicks() - *pollTime) >1000)) {
 				gamestate = PLAY_STATE;
-				drawEverything();
-				*pollTime = SDL_GetTicks();
+				showPlayfield();
+				*pollTime = gameTicks();
+				animationTime = *pollTime;
 			}
 			*keyPressed = 0;
 		break;
 		case NEXT_LEVEL:
-			if((SDL_GetTicks() - *pollTime) >1000) {
+			if((gameTicks() - *pollTime) >1000) {
 				setPlayfield();
-				*pollTime = SDL_GetTicks();
+				*pollTime = gameTicks();
 			}
 		break;
 		case END_GAME:
-			if((SDL_GetTicks() - *pollTime) >1000) {
+			if((gameTicks() - *pollTime) >1000) {
 				endGame();
-				*pollTime = SDL_GetTicks();
+				*pollTime = gameTicks();
 				gamestate = START_MENU;
 			}
 		break;
 		case CREDITS: // TODO
 		break;
 		case START_MENU:
-			if((SDL_GetTicks() - *pollTime) >1000) {
-				drawText(TITLE);
+			if((gameTicks() - *pollTime) >1000) {
+				showText(TITLE);
 			}
 		break;
 	}
 }
 
+/*!*****************************************************************************
+	\brief	Pass one key event to the game and the recording
+
+	\param	event
+		Key pressed or released
+
+	\param	keyPressed
+		SDL keyboard input handler
+
+	\param	pressedOnce
+		Keyboard repetitive input limiter
+
+	\date	19.10.26
+*******************************************************************************/
+void handleKey(const struct keyEvent *event, SDLKey *keyPressed, int *pressedOnce) {
+	recordKey(gameTicks() - logicStart, event->type, event->sym);
+	if (event->type == SDL_KEYDOWN) {
+		*keyPressed = event->sym;
+		if((*pressedOnce)++) {
+			*keyPressed = 0;
+		}
+	}
+	else if (event->type == SDL_KEYUP) {
+		*keyPressed = 0;
+		*pressedOnce = 0;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	The game logic loop, run on its own thread
+
+	Reads keyboard events from the render thread, or from a replay, and
+	publishes frames back. While replaying only ESC is taken from the
+	keyboard.
+
+	\param	data
+		Not used
+
+	\date	19.10.26
+*******************************************************************************/
+int runLogic(void *data) {
+	struct keyEvent event;
+	SDLKey keyPressed = 0;
+
+	int pressedOnce=0;
+	int pollTime = 0;
+
+	pollTime = gameTicks();
+	logicStart = pollTime;
+	if(resumeGame()) {
+		resetPlayfield();
+		showText(TITLE);
+	}
+	while (pipelineRunning()) {
+		if ((replayPath != NULL) && replayKey(gameTicks() - logicStart, &event)) {
+			handleKey(&event, &keyPressed, &pressedOnce);
+		}
+		else if (popKey(&event)) {
+			if ((replayPath == NULL) || (event.sym == SDLK_ESCAPE)) {
+				handleKey(&event, &keyPressed, &pressedOnce);
+			}
+		}
+		else {
+			SDL_Delay(1);
+		}
+		if(keyPressed == SDLK_ESCAPE) {
+			stopPipeline();
+			break;
+		}
+	
+		doGameGraphs(&keyPressed, &pressedOnce, &pollTime);	
+	}
+	saveGame();
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Play the game on a virtual clock and write the frames to a file
+
+	Everything runs on this thread without waiting, one millisecond of game
+	time per loop and a frame every 1000 / fps milliseconds. Keys come from
+	a replay or, without one, from the bot. Stops on ESC, when the bot loses
+	or a while after the replay has ended. With a snapshot file the game is
+	also checkpointed every SNAPSHOT_INTERVAL milliseconds of game time, so
+	a run that is killed loses at most that much.
+
+	\return	0 on success, -1 if writing the frames failed
+
+	\date	19.10.26
+*******************************************************************************/
+int runCapture(void) {
+	struct keyEvent event;
+	const struct frame *f, *shown = NULL;
+	SDLKey keyPressed = 0, botKey = 0;
+	unsigned int nextBot = BOT_DELAY, frameCount = 0, nextCheckpoint = SNAPSHOT_INTERVAL;
+	int pressedOnce = 0, pollTime, result = 0;
+
+	virtualClock = 1;
+	virtualTime = 0;
+	logicStart = 0;
+	pollTime = gameTicks();
+	if(resumeGame()) {
+		resetPlayfield();
+		showText(TITLE);
+	}
+	while (pipelineRunning()) {
+		if(replayPath != NULL) {
+			while(replayKey(virtualTime, &event)) {
+				handleKey(&event, &keyPressed, &pressedOnce);
+			}
+			if(replayFinished() && (virtualTime > replayLastTime() + CAPTURE_TAIL)) {
+				break;
+			}
+		}
+		else if(botKey) {
+			// Every press is released on the next millisecond
+			event.type = SDL_KEYUP;
+			event.sym = botKey;
+			handleKey(&event, &keyPressed, &pressedOnce);
+			botKey = 0;
+		}
+		else if(virtualTime >= nextBot) {
+			if(gamestate == START_MENU) {
+				break;
+			}
+			event.type = SDL_KEYDOWN;
+			if(gamestate == PLAY_STATE) {
+				updateDangers();
+				event.sym = botMove(&danger, &playfield, HERO_X, HERO_Y);
+			}
+			else {
+				event.sym = SDLK_SPACE;
+			}
+			handleKey(&event, &keyPressed, &pressedOnce);
+			botKey = event.sym;
+			nextBot = virtualTime + BOT_DELAY;
+		}
+		if(keyPressed == SDLK_ESCAPE) {
+			break;
+		}
+
+		doGameGraphs(&keyPressed, &pressedOnce, &pollTime);
+
+		if(virtualTime >= nextCheckpoint) {
+			saveGame();
+			nextCheckpoint = virtualTime + SNAPSHOT_INTERVAL;
+		}
+
+		if(virtualTime >= (unsigned int)((unsigned long long)frameCount * 1000 / captureFps)) {
+			if((f = latestFrame(&frames)) != NULL) {
+				shown = f;
+			}
+			if((shown != NULL) && writeCapture(shown)) {
+				fprintf(stderr, "Couldn't write frame %u\n", frameCount);
+				result = -1;
+				break;
+			}
+			frameCount++;
+		}
+		virtualTime++;
+	}
+	stopPipeline();
+	saveGame();
+	fprintf(stderr, "Captured %u frames of %u ms\n", frameCount, virtualTime);
+	return result;
+}
+
+/*!*****************************************************************************
+	\brief	Watch bot games on all cores, drawn as a mosaic of thumbnails
+
+	The games never wait for the window, which is drawn at SPECTATOR_FPS
+	frames a second with the latest round of turns. Stops on ESC.
+
+	\return	0 on success, -1 if the games could not be started
+
+	\date	19.10.26
+*******************************************************************************/
+int runSpectator(void) {
+	SDL_Event event;
+	unsigned int next, now;
+
+	if(startSpectator(&spectator, spectateCount, playfield.w, playfield.h, camera.w, camera.h, randomBits())) {
+		return -1;
+	}
+	renderer->fill(NULL, 0x000000);
+	next = SDL_GetTicks();
+	while (pipelineRunning()) {
+		while (SDL_PollEvent(&event)) {
+			if (((event.type == SDL_KEYDOWN) && (event.key.keysym.sym == SDLK_ESCAPE)) || (event.type == SDL_QUIT)) {
+				stopPipeline();
+			}
+		}
+		if(drawMosaic(&spectator)) {
+			renderer->present();
+		}
+		next += 1000 / SPECTATOR_FPS;
+		now = SDL_GetTicks();
+		if((int)(next - now) > 0) {
+			SDL_Delay(next - now);
+		}
+		else {
+			next = now;
+		}
+	}
+	stopSpectator(&spectator);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Read the field and window sizes from the command line
+
+	\param	argc, argv
+		Command line of the game
+
+	\return	0 on success, -1 on an unknown or bad option
+
+	\date	19.10.26
+*******************************************************************************/
+int readOptions(int argc, char *argv[]) {
+	int option, w = FIELD_X, h = FIELD_Y, windowW = 0, windowH = 0, seeded = 0, cell = FIELD_WIDTH;
+	unsigned int seed = (unsigned int)TickCount();
+
+	while((option = getopt(argc, argv, "x:y:W:H:C:S:c:p:r:s:f:a:b:DL:G:T:Q:M:R:")) != -1) {
+		switch(option) {
+			case 'x':
+				w = atoi(optarg);
+			break;
+			case 'y':
+				h = atoi(optarg);
+			break;
+			case 'W':
+				windowW = atoi(optarg);
+			break;
+			case 'H':
+				windowH = atoi(optarg);
+			break;
+			case 'C':
+				cell = atoi(optarg);
+			break;
+			case 'S':
+				windowScale = atoi(optarg);
+			break;
+			case 'c':
+				capturePath = optarg;
+			break;
+			case 'p':
+				replayPath = optarg;
+			break;
+			case 'r':
+				recordPath = optarg;
+			break;
+			case 's':
+				seed = (unsigned int)strtoul(optarg, NULL, 0);
+				seeded = 1;
+			break;
+			case 'f':
+				captureFps = atoi(optarg);
+			break;
+			case 'a':
+				assetPath = optarg;
+			break;
+			case 'b':
+				rendererName = optarg;
+			break;
+			case 'D':
+				dangerOverlay = 1;
+			break;
+			case 'L':
+				cachePath = optarg;
+			break;
+			case 'G':
+				generateCount = atoi(optarg);
+			break;
+			case 'T':
+				scorePath = optarg;
+			break;
+			case 'Q':
+				scoreQuery = optarg;
+			break;
+			case 'M':
+				spectateCount = atoi(optarg);
+			break;
+			case 'R':
+				snapshotPath = optarg;
+			break;
+			default:
+				fprintf(stderr, "Usage: %s [-x columns] [-y rows] [-W window width] [-H window height]\n"
+					"\t[-C cell size] [-S window scale]\n"
+					"\t[-s seed] [-r record to file] [-p play back file] [-c capture to file.ppm, file.y4m or -] [-f fps]\n"
+					"\t[-a asset blob] [-b surface or texture renderer] [-D show danger]\n"
+					"\t[-L level cache] [-G levels to search into the cache]\n"
+					"\t[-T score log] [-Q top, human, replay, bot or seed=number]\n"
+					"\t[-M bot games to watch] [-R snapshot to resume from and save to]\n", argv[0]);
+				return -1;
+		}
+	}
+	// A replay brings its own seed and field size
+	if((replayPath != NULL) && openReplay(replayPath, &seed, &w, &h)) {
+		return -1;
+	}
+	if(seeded && (replayPath != NULL)) {
+		fprintf(stderr, "Seed of the replay is used\n");
+	}
+	// So does a snapshot, which can not go with a replay or a recording
+	if(snapshotPath != NULL) {
+		if((replayPath != NULL) || (recordPath != NULL)) {
+			fprintf(stderr, "A snapshot is not replayed or recorded\n");
+			return -1;
+		}
+		if(openSnapshot(&resumed, snapshotPath)) {
+			return -1;
+		}
+		if(resumed.header != NULL) {
+			w = resumed.header->w;
+			h = resumed.header->h;
+		}
+	}
+	seedRandom(seed);
+	if((recordPath != NULL) && openRecording(recordPath, seed, w, h)) {
+		return -1;
+	}
+	if((capturePath != NULL) && openCapture(capturePath, captureFps)) {
+		return -1;
+	}
+	if((w < 2) || (h < 2) || (windowW < 0) || (windowH < 0) || (captureFps < 1) || (captureFps > 1000) ||
+		(cell < 1) || (cell > 1000) || (windowScale < 1) || (windowScale > 8)) {
+		fprintf(stderr, "Bad field or window size\n");
+		return -1;
+	}
+	if((generateCount < 0) || (generateCount && (cachePath == NULL))) {
+		fprintf(stderr, "Levels are searched into a level cache given with -L\n");
+		return -1;
+	}
+	if((cachePath != NULL) && loadLevelCache(&levelCache, cachePath)) {
+		return -1;
+	}
+	if((spectateCount < 0) || (spectateCount > SPECTATOR_MAX_GAMES) ||
+		(spectateCount && ((capturePath != NULL) || (replayPath != NULL) || (recordPath != NULL)))) {
+		fprintf(stderr, "Up to %d games are watched without capture, replay or recording\n", SPECTATOR_MAX_GAMES);
+		return -1;
+	}
+	if((scoreQuery != NULL) && (scorePath == NULL)) {
+		fprintf(stderr, "Scores are asked from a score log given with -T\n");
+		return -1;
+	}
+	if((scorePath != NULL) && openScores(&scores, scorePath)) {
+		return -1;
+	}
+	if(createBoard(&playfield, w, h) || initFrames(&frames, w, h) || createDanger(&danger, w, h)) {
+		fprintf(stderr, "Not enough memory for a %dx%d field\n", w, h);
+		return -1;
+	}
+	// The danger map follows the cells the turns change
+	playfield.journal = &playfieldJournal;
+	playfieldJournal.reset = 1;
+	// By default the window shows the whole field, but never more than
+	// FIELD_X x FIELD_Y cells, and the scale grows the cells and the window
+	cell *= windowScale;
+	if(!windowW) {
+		windowW = (w < FIELD_X)? w * cell: FIELD_X * cell;
+	}
+	if(!windowH) {
+		windowH = (h < FIELD_Y)? h * cell: FIELD_Y * cell;
+	}
+	initCamera(&camera, windowW, windowH, cell);
+	return 0;
+}
+
 /*!*****************************************************************************
 	\brief	The main loop of the game
 
+	Handles input and drawing, while the game logic runs on a thread of its
+	own, so a slow frame never holds back the turns.
+
 	\date	7.1.18
 
 	\author	Lari Koskinen
@@ -1001,40 +1995,82 @@ void doGameGraphs(SDLKey *keyPressed, int *pressedOnce, int *pollTime) {
 int main(int argc, char *argv[])
 {
 	SDL_Event event;
-	SDLKey keyPressed = 0;
-
-	int pressedOnce=0;
-	int pollTime = 0;
+	SDL_Thread *logic;
+	const struct frame *f, *shown = NULL;
+	int redraw;
 	
+	if(readOptions(argc, argv)) {
+		return -1;
+	}
+
+	if(generateCount) {
+		return generateLevels(generateCount);
+	}
+
+	if(scoreQuery != NULL) {
+		return printScores(scoreQuery);
+	}
+
+	if(capturePath != NULL) {
+		// No window is needed, frames are drawn to memory only
+		setenv("SDL_VIDEODRIVER", "dummy", 1);
+		rendererName = "surface";
+	}
+
 	if(init()) {
 		return -1;
 	}
 
-	pollTime = SDL_GetTicks();
-	resetPlayfield();
-	drawText(TITLE);
-	while (1) {
-		if (SDL_PollEvent(&event)) {
-			if (event.type == SDL_KEYDOWN) {
-				keyPressed = event.key.keysym.sym;
-				if(pressedOnce++) {
-					keyPressed = 0;
-				}
+	if(capturePath != NULL) {
+		runCapture();
+		quit();
+	}
+
+	if(spectateCount) {
+		runSpectator();
+		quit();
+	}
+
+	if((logic = SDL_CreateThread(runLogic, NULL)) == NULL) {
+		fprintf(stderr, "Couldn't start game logic: %s\n", SDL_GetError());
+		quit();
+	}
+	while (pipelineRunning()) {
+		redraw = 0;
+		while (SDL_PollEvent(&event)) {
+			if ((event.type == SDL_KEYDOWN) &&
+				((event.key.keysym.sym == SDLK_KP_PLUS) || (event.key.keysym.sym == SDLK_KP_MINUS))) {
+				// Zooming only changes the view, the game never sees these keys
+				zoomCamera(&camera, event.key.keysym.sym == SDLK_KP_PLUS);
+				redraw = 1;
+			}
+			else if ((event.type == SDL_KEYDOWN) && (event.key.keysym.sym == SDLK_d)) {
+				// The frames always carry the danger, only the drawing changes
+				dangerOverlay = !dangerOverlay;
+				redraw = 1;
+			}
+			else if ((event.type == SDL_KEYDOWN) || (event.type == SDL_KEYUP)) {
+				pushKey(event.type, event.key.keysym.sym);
 			}
-			else if (event.type == SDL_KEYUP) {
-				keyPressed = 0;
-				pressedOnce = 0;
+			else if (event.type == SDL_QUIT) {
+				stopPipeline();
 			}
 		}
-		if(keyPressed == SDLK_ESCAPE) {
-			quit();
+
+		if((f = latestFrame(&frames)) != NULL) {
+			shown = f;
+			redraw = 1;
+		}
+		if(redraw && (shown != NULL)) {
+			drawEverything(shown);
+			renderer->present();
+		}
+		else {
+			SDL_Delay(1);
 		}
-	
-		doGameGraphs(&keyPressed, &pressedOnce, &pollTime);	
-		
-		// Update whole screen
-		SDL_UpdateRect(screen, 0, 0, 0, 0);
 	}
+	SDL_WaitThread(logic, NULL);
+	quit();
 		
 	return 0;
 }
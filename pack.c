@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASSET_PACKER
+#include "assets.h"
+
+/*
+	Packs the game bitmaps and font into one asset blob:
+
+	pack assets.bin evil.bmp hero.bmp scrapheap.bmp arial.ttf
+
+	Bitmaps are converted to the 16 bit 565 format the game draws in, so
+	they need no decoding or converting when the game starts. Every other
+	file is stored as it is. Assets are named by their file name without
+	the directory and extension.
+*/
+
+#define MAX_ASSETS 32
+
+/*!*****************************************************************************
+	\brief	Read a whole file to memory
+
+	\param	path
+		File to read
+
+	\param	size
+		Size of the file
+
+	\return	Contents of the file or NULL on failure
+
+	\date	19.10.26
+*******************************************************************************/
+static unsigned char *readFile(const char *path, long *size) {
+	FILE *fp;
+	unsigned char *data = NULL;
+
+	if((fp = fopen(path, "rb")) == NULL) {
+		perror(path);
+		return NULL;
+	}
+	if(!fseek(fp, 0, SEEK_END) && ((*size = ftell(fp)) >= 0) && !fseek(fp, 0, SEEK_SET)) {
+		if(((data = malloc(*size ? *size: 1)) != NULL) && (fread(data, 1, *size, fp) != (size_t)*size)) {
+			free(data);
+			data = NULL;
+		}
+	}
+	fclose(fp);
+	if(data == NULL) {
+		fprintf(stderr, "Couldn't read %s\n", path);
+	}
+	return data;
+}
+
+/*!*****************************************************************************
+	\brief	Read a little endian value from a file in memory
+
+	\date	19.10.26
+*******************************************************************************/
+static uint32_t le(const unsigned char *p, int bytes) {
+	uint32_t value = 0;
+	while(bytes--) {
+		value = (value << 8) | p[bytes];
+	}
+	return value;
+}
+
+/*!*****************************************************************************
+	\brief	Convert an uncompressed 24 or 32 bit BMP to 565 pixels
+
+	\param	file, size
+		BMP file in memory
+
+	\param	entry
+		Gets the size and format of the image
+
+	\return	Pixels of the image or NULL if the file is not a supported BMP
+
+	\date	19.10.26
+*******************************************************************************/
+static uint16_t *convertBitmap(const unsigned char *file, long size, struct assetEntry *entry) {
+	uint32_t offset, compression;
+	int32_t w, h;
+	int bpp, stride, x, y, row;
+	const unsigned char *p;
+	uint16_t *pixels;
+
+	if((size < 54) || (file[0] != 'B') || (file[1] != 'M')) {
+		return NULL;
+	}
+	offset = le(file + 10, 4);
+	w = (int32_t)le(file + 18, 4);
+	h = (int32_t)le(file + 22, 4);
+	bpp = (int)le(file + 28, 2);
+	compression = le(file + 30, 4);
+	if((w <= 0) || (w > 0xFFFF) || (h == 0) || (h > 0xFFFF) || (h < -0xFFFF) || ((bpp != 24) && (bpp != 32)) || (compression != 0)) {
+		return NULL;
+	}
+	stride = ((w * bpp / 8) + 3) & ~3;
+	if((long)offset + (long)stride * abs(h) > size) {
+		return NULL;
+	}
+	entry->w = (uint16_t)w;
+	entry->h = (uint16_t)abs(h);
+	entry->pitch = (uint16_t)(((w * 2) + 3) & ~3);
+	entry->bpp = 16;
+	entry->rmask = 0xF800;
+	entry->gmask = 0x07E0;
+	entry->bmask = 0x001F;
+	if((pixels = calloc(entry->h, entry->pitch)) == NULL) {
+		return NULL;
+	}
+	for(y=0; y<entry->h; y++) {
+		// Rows are stored bottom up unless the height is negative
+		row = (h > 0)? entry->h - 1 - y: y;
+		p = file + offset + (long)row * stride;
+		for(x=0; x<w; x++, p += bpp / 8) {
+			pixels[y * (entry->pitch / 2) + x] = (uint16_t)(((p[2] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[0] >> 3));
+		}
+	}
+	return pixels;
+}
+
+/*!*****************************************************************************
+	\brief	Set the asset name from the file name
+
+	\date	19.10.26
+*******************************************************************************/
+static void assetName(char *name, const char *path) {
+	const char *base = strrchr(path, '/');
+	size_t length;
+
+	base = (base != NULL)? base + 1: path;
+	length = strcspn(base, ".");
+	length = (length < ASSET_NAME - 1)? length: ASSET_NAME - 1;
+	memset(name, 0, ASSET_NAME);
+	memcpy(name, base, length);
+}
+
+/*!*****************************************************************************
+	\brief	Pack the sprites and the font into an asset blob
+
+	Bitmaps are converted to the 16 bit format of the game, other files
+	are packed as they are. A blob that could not be written in full is
+	removed.
+
+	\param	argc, argv
+		Blob to write and the files to pack into it
+
+	\return	0 on success, 1 on failure
+
+	\date	19.10.26
+*******************************************************************************/
+int main(int argc, char *argv[]) {
+	struct assetHeader header;
+	struct assetEntry entries[MAX_ASSETS];
+	void *data[MAX_ASSETS];
+	unsigned char *file, padding[ASSET_ALIGN] = {0};
+	const char *dot;
+	uint32_t offset;
+	long size;
+	FILE *out;
+	int i, failed, count = argc - 2;
+
+	if((count < 1) || (count > MAX_ASSETS)) {
+		fprintf(stderr, "Usage: %s blob file...\n", argv[0]);
+		return 1;
+	}
+	memset(entries, 0, sizeof(entries));
+	offset = sizeof(header) + count * sizeof(*entries);
+	for(i=0; i<count; i++) {
+		if((file = readFile(argv[i + 2], &size)) == NULL) {
+			return 1;
+		}
+		assetName(entries[i].name, argv[i + 2]);
+		dot = strrchr(argv[i + 2], '.');
+		if((dot != NULL) && !strcmp(dot, ".bmp")) {
+			if((data[i] = convertBitmap(file, size, &entries[i])) == NULL) {
+				fprintf(stderr, "%s is not an uncompressed 24 or 32 bit BMP\n", argv[i + 2]);
+				return 1;
+			}
+			entries[i].size = (uint32_t)entries[i].pitch * entries[i].h;
+			free(file);
+		}
+		else {
+			data[i] = file;
+			entries[i].size = (uint32_t)size;
+		}
+		offset = (offset + ASSET_ALIGN - 1) & ~(ASSET_ALIGN - 1);
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+	header.magic = ASSET_MAGIC;
+	header.version = ASSET_VERSION;
+	header.count = (uint32_t)count;
+	header.size = offset;
+
+	if((out = fopen(argv[1], "wb")) == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+	failed = (fwrite(&header, sizeof(header), 1, out) != 1) ||
+		(fwrite(entries, sizeof(*entries), count, out) != (size_t)count);
+	offset = sizeof(header) + count * sizeof(*entries);
+	for(i=0; i<count; i++) {
+		failed |= (fwrite(padding, 1, entries[i].offset - offset, out) != entries[i].offset - offset) ||
+			(fwrite(data[i], 1, entries[i].size, out) != entries[i].size);
+		offset = entries[i].offset + entries[i].size;
+		free(data[i]);
+	}
+	failed |= fclose(out) != 0;
+	if(failed) {
+		perror(argv[1]);
+		remove(argv[1]);
+		return 1;
+	}
+	return 0;
+}
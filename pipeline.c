@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "pipeline.h"
+
+#define NEW_FRAME 4
+
+struct tripleBuffer frames;
+
+static struct keyEvent keyQueue[KEY_QUEUE_SIZE];
+static unsigned int keyHead, keyTail;
+static int running = 1;
+
+/*!*****************************************************************************
+	\brief	Reserve the frames of a triple buffer, none of them waiting to be read
+
+	\param	buffer
+		Triple buffer handler
+
+	\param	w, h
+		Size of the field in cells
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int initFrames(struct tripleBuffer *buffer, int w, int h) {
+	int i;
+
+	memset(buffer, 0, sizeof(*buffer));
+	buffer->back = 0;
+	buffer->middle = 1;
+	buffer->front = 2;
+	for(i=0; i<3; i++) {
+		buffer->slot[i].danger = malloc((size_t)w * h);
+		if(createBoard(&buffer->slot[i].playfield, w, h) || (buffer->slot[i].danger == NULL)) {
+			freeFrames(buffer);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Free the frames of a triple buffer
+
+	\param	buffer
+		Triple buffer handler
+
+	\date	19.10.26
+*******************************************************************************/
+void freeFrames(struct tripleBuffer *buffer) {
+	int i;
+
+	for(i=0; i<3; i++) {
+		freeBoard(&buffer->slot[i].playfield);
+		free(buffer->slot[i].danger);
+		buffer->slot[i].danger = NULL;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Get the frame the writer may fill next
+
+	\param	buffer
+		Triple buffer handler
+
+	\date	19.10.26
+*******************************************************************************/
+struct frame *backFrame(struct tripleBuffer *buffer) {
+	return &buffer->slot[buffer->back];
+}
+
+/*!*****************************************************************************
+	\brief	Publish the filled back frame as the newest one
+
+	Never waits for the reader, a frame not read yet is simply replaced.
+
+	\param	buffer
+		Triple buffer handler
+
+	\date	19.10.26
+*******************************************************************************/
+void publishBackFrame(struct tripleBuffer *buffer) {
+	int old = __atomic_exchange_n(&buffer->middle, buffer->back | NEW_FRAME, __ATOMIC_ACQ_REL);
+	buffer->back = old & ~NEW_FRAME;
+}
+
+/*!*****************************************************************************
+	\brief	Get the newest published frame
+
+	\param	buffer
+		Triple buffer handler
+
+	\return	The frame or NULL if nothing has been published since the last call
+
+	\date	19.10.26
+*******************************************************************************/
+const struct frame *latestFrame(struct tripleBuffer *buffer) {
+	int old;
+
+	if(!(__atomic_load_n(&buffer->middle, __ATOMIC_ACQUIRE) & NEW_FRAME)) {
+		return NULL;
+	}
+	old = __atomic_exchange_n(&buffer->middle, buffer->front, __ATOMIC_ACQ_REL);
+	buffer->front = old & ~NEW_FRAME;
+	return &buffer->slot[buffer->front];
+}
+
+/*!*****************************************************************************
+	\brief	Queue a keyboard event for the logic thread
+
+	\param	type
+		SDL_KEYDOWN or SDL_KEYUP
+
+	\param	sym
+		SDL keyboard value
+
+	\return	0 on success, -1 if the queue is full and the event was dropped
+
+	\date	19.10.26
+*******************************************************************************/
+int pushKey(int type, SDLKey sym) {
+	unsigned int head = __atomic_load_n(&keyHead, __ATOMIC_RELAXED);
+
+	if((head - __atomic_load_n(&keyTail, __ATOMIC_ACQUIRE)) >= KEY_QUEUE_SIZE) {
+		return -1;
+	}
+	keyQueue[head % KEY_QUEUE_SIZE].type = type;
+	keyQueue[head % KEY_QUEUE_SIZE].sym = sym;
+	__atomic_store_n(&keyHead, head + 1, __ATOMIC_RELEASE);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Take the oldest keyboard event from the queue
+
+	\param	event
+		Where to store the event
+
+	\return	1 if an event was taken, 0 if the queue is empty
+
+	\date	19.10.26
+*******************************************************************************/
+int popKey(struct keyEvent *event) {
+	unsigned int tail = __atomic_load_n(&keyTail, __ATOMIC_RELAXED);
+
+	if(tail == __atomic_load_n(&keyHead, __ATOMIC_ACQUIRE)) {
+		return 0;
+	}
+	*event = keyQueue[tail % KEY_QUEUE_SIZE];
+	__atomic_store_n(&keyTail, tail + 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+/*!*****************************************************************************
+	\brief	Ask both threads to finish
+
+	\date	19.10.26
+*******************************************************************************/
+void stopPipeline(void) {
+	__atomic_store_n(&running, 0, __ATOMIC_RELEASE);
+}
+
+/*!*****************************************************************************
+	\brief	Check if the game is still running
+
+	\date	19.10.26
+*******************************************************************************/
+int pipelineRunning(void) {
+	return __atomic_load_n(&running, __ATOMIC_ACQUIRE);
+}
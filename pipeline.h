@@ -0,0 +1,84 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "advisor.h"
+#include "scores.h"
+
+#define KEY_QUEUE_SIZE 64
+
+/*!*****************************************************************************
+	\brief	List of screens a frame can show
+
+	\date	19.10.26
+*******************************************************************************/
+enum {
+	SCREEN_FIELD=0,
+	SCREEN_TEXT,
+};
+
+/*!*****************************************************************************
+	\brief	Everything the renderer needs to draw one frame
+
+	Filled by the logic thread and never changed after it has been published.
+	The danger of each cell is capped at 255. Text screens carry the score
+	summary.
+
+	\date	19.10.26
+*******************************************************************************/
+struct frame {
+	int screen;
+	int text;
+	int currentLevel;
+	int safeTeleports;
+	int heroX, heroY;
+	int heroImage;
+	int updateMovement;
+	struct advice advice;
+	struct scoreSummary scores;
+	unsigned char *danger;
+	struct board playfield;
+};
+
+/*!*****************************************************************************
+	\brief	Lock-free triple buffer of frames
+
+	The writer owns the back slot and the reader the front slot, the middle
+	slot is swapped between them together with a flag telling it is new.
+
+	\date	19.10.26
+*******************************************************************************/
+struct tripleBuffer {
+	struct frame slot[3];
+	int back;
+	int front;
+	int middle;
+};
+
+/*!*****************************************************************************
+	\brief	Key press or release passed from the render thread to the logic
+
+	\date	19.10.26
+*******************************************************************************/
+struct keyEvent {
+	int type;
+	SDLKey sym;
+};
+
+extern struct tripleBuffer frames;
+
+int initFrames(struct tripleBuffer *buffer, int w, int h);
+void freeFrames(struct tripleBuffer *buffer);
+struct frame *backFrame(struct tripleBuffer *buffer);
+void publishBackFrame(struct tripleBuffer *buffer);
+const struct frame *latestFrame(struct tripleBuffer *buffer);
+
+int pushKey(int type, SDLKey sym);
+int popKey(struct keyEvent *event);
+
+void stopPipeline(void);
+int pipelineRunning(void);
+
+#endif
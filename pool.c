@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sdl.h"
+#include "pool.h"
+
+/*!*****************************************************************************
+	\brief	Get the amount of processor cores online
+
+	\date	19.10.26
+*******************************************************************************/
+int cpuCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1)? 1: (count > POOL_MAX_THREADS)? POOL_MAX_THREADS: (int)count;
+}
+
+/*!*****************************************************************************
+	\brief	Take jobs until all of them have been handed out
+
+	\param	p
+		Pool handler
+
+	\date	19.10.26
+*******************************************************************************/
+static void takeJobs(struct pool *p) {
+	int index;
+	while((index = __atomic_fetch_add(&p->next, 1, __ATOMIC_ACQ_REL)) < p->jobs) {
+		p->job(p->data, index);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Worker thread waiting for jobs
+
+	\param	data
+		Pool handler
+
+	\date	19.10.26
+*******************************************************************************/
+static int poolWorker(void *data) {
+	struct pool *p = (struct pool *)data;
+	unsigned int seen = 0;
+
+	SDL_LockMutex(p->lock);
+	while(1) {
+		while((p->generation == seen) && !p->quit) {
+			SDL_CondWait(p->start, p->lock);
+		}
+		if(p->quit) {
+			break;
+		}
+		seen = p->generation;
+		SDL_UnlockMutex(p->lock);
+
+		takeJobs(p);
+
+		SDL_LockMutex(p->lock);
+		if(!--p->busy) {
+			SDL_CondSignal(p->done);
+		}
+	}
+	SDL_UnlockMutex(p->lock);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Create a pool of worker threads
+
+	\param	threads
+		Amount of threads working in addition to the caller of runPool
+
+	\return	Pool handler or NULL on failure
+
+	\date	19.10.26
+*******************************************************************************/
+struct pool *createPool(int threads) {
+	struct pool *p;
+	int i;
+
+	if((p = calloc(1, sizeof(*p))) == NULL) {
+		return NULL;
+	}
+	threads = (threads < 0)? 0: (threads > POOL_MAX_THREADS)? POOL_MAX_THREADS: threads;
+	p->lock = SDL_CreateMutex();
+	p->start = SDL_CreateCond();
+	p->done = SDL_CreateCond();
+	if((p->lock == NULL) || (p->start == NULL) || (p->done == NULL)) {
+		destroyPool(p);
+		return NULL;
+	}
+	for(i=0; i<threads; i++) {
+		if((p->thread[i] = SDL_CreateThread(poolWorker, p)) == NULL) {
+			break;
+		}
+		p->threads++;
+	}
+	return p;
+}
+
+/*!*****************************************************************************
+	\brief	Run jobs on the pool and wait until all of them are finished
+
+	The calling thread takes jobs too, so a pool without threads runs them
+	all in the caller.
+
+	\param	p
+		Pool handler
+
+	\param	jobs
+		Amount of jobs, each called with its index from 0 to jobs - 1
+
+	\param	job
+		Function doing one job
+
+	\param	data
+		Passed to every job
+
+	\date	19.10.26
+*******************************************************************************/
+void runPool(struct pool *p, int jobs, void (*job)(void *data, int index), void *data) {
+	SDL_LockMutex(p->lock);
+	p->job = job;
+	p->data = data;
+	p->jobs = jobs;
+	p->next = 0;
+	p->busy = p->threads;
+	p->generation++;
+	SDL_CondBroadcast(p->start);
+	SDL_UnlockMutex(p->lock);
+
+	takeJobs(p);
+
+	SDL_LockMutex(p->lock);
+	while(p->busy) {
+		SDL_CondWait(p->done, p->lock);
+	}
+	SDL_UnlockMutex(p->lock);
+}
+
+/*!*****************************************************************************
+	\brief	Stop the worker threads and free the pool
+
+	\param	p
+		Pool handler
+
+	\date	19.10.26
+*******************************************************************************/
+void destroyPool(struct pool *p) {
+	int i;
+
+	if(p == NULL) {
+		return;
+	}
+	if(p->lock != NULL) {
+		SDL_LockMutex(p->lock);
+		p->quit = 1;
+		if(p->start != NULL) {
+			SDL_CondBroadcast(p->start);
+		}
+		SDL_UnlockMutex(p->lock);
+	}
+	for(i=0; i<p->threads; i++) {
+		SDL_WaitThread(p->thread[i], NULL);
+	}
+	if(p->done != NULL) {
+		SDL_DestroyCond(p->done);
+	}
+	if(p->start != NULL) {
+		SDL_DestroyCond(p->start);
+	}
+	if(p->lock != NULL) {
+		SDL_DestroyMutex(p->lock);
+	}
+	free(p);
+}
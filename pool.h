@@ -0,0 +1,33 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "sdl.h"
+
+#define POOL_MAX_THREADS 64
+
+/*!*****************************************************************************
+	\brief	Fixed set of worker threads running numbered jobs
+
+	\date	19.10.26
+*******************************************************************************/
+struct pool {
+	SDL_Thread *thread[POOL_MAX_THREADS];
+	int threads;
+	SDL_mutex *lock;
+	SDL_cond *start;
+	SDL_cond *done;
+	unsigned int generation;
+	int busy;
+	int quit;
+	void (*job)(void *data, int index);
+	void *data;
+	int jobs;
+	int next;
+};
+
+int cpuCount(void);
+struct pool *createPool(int threads);
+void runPool(struct pool *p, int jobs, void (*job)(void *data, int index), void *data);
+void destroyPool(struct pool *p);
+
+#endif
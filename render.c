@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "render.h"
+
+static SDL_Surface *sheet[SHEETS];
+#ifdef USE_SDL2
+static SDL_Window *window;
+#endif
+
+/*
+	Backends in the order they are tried, the surface one works everywhere
+*/
+static const struct renderer *renderers[] = {
+#ifdef USE_SDL2
+	&textureRenderer,
+#endif
+	&surfaceRenderer,
+};
+
+const struct renderer *renderer = &surfaceRenderer;
+
+/*!*****************************************************************************
+	\brief	Open the window with the first backend that works
+
+	\param	name
+		Backend to use, NULL for the best one available
+
+	\param	w, h
+		Size of the window
+
+	\param	caption
+		Title of the window
+
+	\return	0 on success, -1 if no backend could be opened
+
+	\date	19.10.26
+*******************************************************************************/
+int openRenderer(const char *name, int w, int h, const char *caption) {
+	size_t i;
+
+	for(i=0; i<sizeof(renderers) / sizeof(*renderers); i++) {
+		if((name != NULL) && strcmp(name, renderers[i]->name)) {
+			continue;
+		}
+		if(!renderers[i]->open(w, h, caption)) {
+			renderer = renderers[i];
+			return 0;
+		}
+		fprintf(stderr, "Couldn't draw with %s: %s\n", renderers[i]->name, SDL_GetError());
+	}
+	if(name != NULL) {
+		fprintf(stderr, "No %s renderer\n", name);
+	}
+	return -1;
+}
+
+/*!*****************************************************************************
+	\brief	Get the position of a text on the screen
+
+	\param	rect
+		Area the text is drawn to
+
+	\param	x, y
+		Position of the text, 0 to centre it
+
+	\param	w
+		Width to draw, 0 for the whole text
+
+	\param	textW, textH
+		Size of the rendered text
+
+	\date	19.10.26
+*******************************************************************************/
+void placeText(SDL_Rect *rect, int x, int y, int w, int textW, int textH) {
+	int middleX = (screen->w / 2) - (textW / 2);
+	int middleY = (screen->h / 2) - (textH / 2);
+
+	initRectangle(rect, ((!x)? middleX: x), ((!y)? middleY: y), ((!w)? textW: w), textH);
+}
+
+/*!*****************************************************************************
+	\brief	Open a window drawn to in software
+
+	\date	19.10.26
+*******************************************************************************/
+static int surfaceOpen(int w, int h, const char *caption) {
+#ifdef USE_SDL2
+	if((window = SDL_CreateWindow(caption, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, h, 0)) == NULL) {
+		return -1;
+	}
+	if((screen = SDL_GetWindowSurface(window)) == NULL) {
+		SDL_DestroyWindow(window);
+		window = NULL;
+		return -1;
+	}
+#else
+	/* Set a 800x600x16 video mode, or the size of the camera view */
+	if((screen = SDL_SetVideoMode(w, h, 16, SDL_SWSURFACE)) == NULL) {
+		return -1;
+	}
+	SDL_WM_SetCaption(caption, 0);
+#endif
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Take the sprite sheets in use
+
+	\date	19.10.26
+*******************************************************************************/
+static int surfaceLoad(SDL_Surface *const sheets[SHEETS]) {
+	memcpy(sheet, sheets, sizeof(sheet));
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Fill an area of the screen, all of it if rect is NULL
+
+	\date	19.10.26
+*******************************************************************************/
+static void surfaceFill(SDL_Rect *rect, Uint32 colour) {
+	SDL_FillRect(screen, rect, SDL_MapRGB(screen->format, (colour >> 16) & 0xFF, (colour >> 8) & 0xFF, colour & 0xFF));
+}
+
+/*!*****************************************************************************
+	\brief	Blend a colour over an area of the screen
+
+	\date	19.10.26
+*******************************************************************************/
+static void surfaceTint(SDL_Rect *rect, Uint32 colour, int alpha) {
+	int x, y, x0, y0, x1, y1;
+	Uint8 r, g, b;
+	Uint32 pixel;
+	Uint8 *row;
+
+	x0 = (rect->x > 0)? rect->x: 0;
+	y0 = (rect->y > 0)? rect->y: 0;
+	x1 = (rect->x + rect->w < screen->w)? rect->x + rect->w: screen->w;
+	y1 = (rect->y + rect->h < screen->h)? rect->y + rect->h: screen->h;
+	if((x0 >= x1) || (y0 >= y1) || ((screen->format->BytesPerPixel != 2) && (screen->format->BytesPerPixel != 4))) {
+		return;
+	}
+	if(SDL_MUSTLOCK(screen) && (SDL_LockSurface(screen) < 0)) {
+		return;
+	}
+	for(y=y0; y<y1; y++) {
+		row = (Uint8 *)screen->pixels + y * screen->pitch;
+		for(x=x0; x<x1; x++) {
+			pixel = (screen->format->BytesPerPixel == 2)? ((Uint16 *)row)[x]: ((Uint32 *)row)[x];
+			SDL_GetRGB(pixel, screen->format, &r, &g, &b);
+			r += (((int)(colour >> 16) & 0xFF) - r) * alpha / 255;
+			g += (((int)(colour >> 8) & 0xFF) - g) * alpha / 255;
+			b += (((int)colour & 0xFF) - b) * alpha / 255;
+			pixel = SDL_MapRGB(screen->format, r, g, b);
+			if(screen->format->BytesPerPixel == 2) {
+				((Uint16 *)row)[x] = (Uint16)pixel;
+			}
+			else {
+				((Uint32 *)row)[x] = pixel;
+			}
+		}
+	}
+	if(SDL_MUSTLOCK(screen)) {
+		SDL_UnlockSurface(screen);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Blit a sprite to the screen, always at its own size
+
+	\date	19.10.26
+*******************************************************************************/
+static void surfaceSprite(int index, SDL_Rect *src, SDL_Rect *dst) {
+	if(sheet[index] != NULL) {
+		SDL_BlitSurface(sheet[index], src, screen, dst);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Render a text and blit it to the screen
+
+	\date	19.10.26
+*******************************************************************************/
+static int surfaceText(int x, int y, int w, const char *text, Uint32 colour) {
+	SDL_Surface *rendText;
+	SDL_Rect rect, src;
+	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF)};
+
+	if((screen != NULL) && (font != NULL) && (text != NULL)) {
+		if((rendText = TTF_RenderText_Solid(font, text, color)) != NULL) {
+			initRectangle(&src, 0, 0, ((!w)? rendText->w: w), rendText->h);
+			placeText(&rect, x, y, w, rendText->w, rendText->h);
+			SDL_BlitSurface(rendText, &src, screen, &rect);
+			SDL_FreeSurface(rendText);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*!*****************************************************************************
+	\brief	Show the screen in the window
+
+	\date	19.10.26
+*******************************************************************************/
+static void surfacePresent(void) {
+#ifdef USE_SDL2
+	SDL_UpdateWindowSurface(window);
+#else
+	// Update whole screen
+	SDL_UpdateRect(screen, 0, 0, 0, 0);
+#endif
+}
+
+/*!*****************************************************************************
+	\brief	Close the window
+
+	\date	19.10.26
+*******************************************************************************/
+static void surfaceClose(void) {
+#ifdef USE_SDL2
+	if(window != NULL) {
+		SDL_DestroyWindow(window);
+	}
+	window = NULL;
+#else
+	SDL_FreeSurface(screen);
+#endif
+	screen = NULL;
+}
+
+const struct renderer surfaceRenderer = {
+	"surface",
+	1,
+	0,
+	surfaceOpen,
+	surfaceLoad,
+	surfaceFill,
+	surfaceTint,
+	surfaceSprite,
+	surfaceText,
+	surfacePresent,
+	surfaceClose,
+};
@@ -0,0 +1,45 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "sdl.h"
+
+enum {
+	SHEET_ROBOT=0,
+	SHEET_HERO,
+	SHEET_TRASH,
+	SHEETS,
+};
+
+/*!*****************************************************************************
+	\brief	Drawing backend, everything drawn on the window goes through one
+
+	Colours are 0xRRGGBB, and a tint blends one over what has been drawn
+	with an alpha of 0 to 255. A text at x or y 0 is centred on that axis, and a
+	width of 0 draws the whole text.
+
+	\date	19.10.26
+*******************************************************************************/
+struct renderer {
+	const char *name;
+	int direct;	// screen->pixels is what gets shown, and can be drawn to
+	int scales;	// sprites can be drawn at any size
+	int (*open)(int w, int h, const char *caption);
+	int (*load)(SDL_Surface *const sheets[SHEETS]);
+	void (*fill)(SDL_Rect *rect, Uint32 colour);
+	void (*tint)(SDL_Rect *rect, Uint32 colour, int alpha);
+	void (*sprite)(int sheet, SDL_Rect *src, SDL_Rect *dst);
+	int (*text)(int x, int y, int w, const char *text, Uint32 colour);
+	void (*present)(void);
+	void (*close)(void);
+};
+
+extern const struct renderer surfaceRenderer;
+#ifdef USE_SDL2
+extern const struct renderer textureRenderer;
+#endif
+extern const struct renderer *renderer;
+
+int openRenderer(const char *name, int w, int h, const char *caption);
+void placeText(SDL_Rect *rect, int x, int y, int w, int textW, int textH);
+
+#endif
@@ -0,0 +1,173 @@
+#include <stdio.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "pipeline.h"
+#include "replay.h"
+
+/*
+	A recording is a text file starting with the seed and field size of the
+	game, followed by one line for every key press and release:
+
+	robots <seed> <columns> <rows>
+	<milliseconds from start> <d or u> <SDL key value>
+*/
+
+static FILE *recording;
+static FILE *replay;
+static struct keyEvent pending;
+static unsigned int pendingTime, lastTime;
+static int hasPending;
+
+/*!*****************************************************************************
+	\brief	Start recording the keys of a game
+
+	\param	path
+		File to write to
+
+	\param	seed
+		Seed of the random values of the game
+
+	\param	w, h
+		Size of the field
+
+	\return	0 on success, -1 if the file could not be created
+
+	\date	19.10.26
+*******************************************************************************/
+int openRecording(const char *path, unsigned int seed, int w, int h) {
+	if((recording = fopen(path, "w")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	fprintf(recording, "robots %u %d %d\n", seed, w, h);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Write one key event to the recording, if one is being made
+
+	\param	time
+		Milliseconds from the start of the game
+
+	\param	type
+		SDL_KEYDOWN or SDL_KEYUP
+
+	\param	sym
+		SDL keyboard value
+
+	\date	19.10.26
+*******************************************************************************/
+void recordKey(unsigned int time, int type, SDLKey sym) {
+	if(recording != NULL) {
+		fprintf(recording, "%u %c %d\n", time, (type == SDL_KEYDOWN)? 'd': 'u', (int)sym);
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Finish the recording
+
+	\date	19.10.26
+*******************************************************************************/
+void closeRecording(void) {
+	if(recording != NULL) {
+		fclose(recording);
+		recording = NULL;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Read the next key event of the replay into the pending one
+
+	\date	19.10.26
+*******************************************************************************/
+static void readPending(void) {
+	char type;
+	int sym;
+
+	hasPending = (fscanf(replay, "%u %c %d", &pendingTime, &type, &sym) == 3);
+	if(hasPending) {
+		pending.type = (type == 'd')? SDL_KEYDOWN: SDL_KEYUP;
+		pending.sym = (SDLKey)sym;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Open a recorded game to be played again
+
+	\param	path
+		File to read from
+
+	\param	seed, w, h
+		Where to store the seed and field size of the recorded game
+
+	\return	0 on success, -1 if the file can't be read
+
+	\date	19.10.26
+*******************************************************************************/
+int openReplay(const char *path, unsigned int *seed, int *w, int *h) {
+	if((replay = fopen(path, "r")) == NULL) {
+		perror(path);
+		return -1;
+	}
+	if(fscanf(replay, "robots %u %d %d", seed, w, h) != 3) {
+		fprintf(stderr, "%s is not a recorded game\n", path);
+		closeReplay();
+		return -1;
+	}
+	readPending();
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get the next recorded key event, if its time has come
+
+	\param	time
+		Milliseconds from the start of the game
+
+	\param	event
+		Where to store the event
+
+	\return	1 if an event was taken, 0 if there is none due yet
+
+	\date	19.10.26
+*******************************************************************************/
+int replayKey(unsigned int time, struct keyEvent *event) {
+	if((replay == NULL) || !hasPending || (pendingTime > time)) {
+		return 0;
+	}
+	*event = pending;
+	lastTime = pendingTime;
+	readPending();
+	return 1;
+}
+
+/*!*****************************************************************************
+	\brief	Check if all recorded events have been played
+
+	\date	19.10.26
+*******************************************************************************/
+int replayFinished(void) {
+	return (replay == NULL) || !hasPending;
+}
+
+/*!*****************************************************************************
+	\brief	Get the time of the last played event
+
+	\date	19.10.26
+*******************************************************************************/
+unsigned int replayLastTime(void) {
+	return lastTime;
+}
+
+/*!*****************************************************************************
+	\brief	Close the recorded game
+
+	\date	19.10.26
+*******************************************************************************/
+void closeReplay(void) {
+	if(replay != NULL) {
+		fclose(replay);
+		replay = NULL;
+	}
+}
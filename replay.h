@@ -0,0 +1,16 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "pipeline.h"
+
+int openRecording(const char *path, unsigned int seed, int w, int h);
+void recordKey(unsigned int time, int type, SDLKey sym);
+void closeRecording(void);
+
+int openReplay(const char *path, unsigned int *seed, int *w, int *h);
+int replayKey(unsigned int time, struct keyEvent *event);
+int replayFinished(void);
+unsigned int replayLastTime(void);
+void closeReplay(void);
+
+#endif
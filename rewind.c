@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "board.h"
+#include "rewind.h"
+
+/*!*****************************************************************************
+	\brief	Forget all turns
+
+	\param	r
+		Rewind buffer handler
+
+	\date	19.10.26
+*******************************************************************************/
+void clearRewind(struct rewindBuffer *r) {
+	r->oldest = r->newest = 0;
+	r->written = 0;
+	r->skip = 0;
+}
+
+/*!*****************************************************************************
+	\brief	Start keeping the changes of a new turn
+
+	\param	r
+		Rewind buffer handler
+
+	\param	state
+		State before the turn
+
+	\date	19.10.26
+*******************************************************************************/
+void startTurn(struct rewindBuffer *r, const struct rewindState *state) {
+	struct rewindTurn *turn;
+
+	if(r->newest - r->oldest == REWIND_TURNS) {
+		r->oldest++;
+	}
+	turn = &r->turns[r->newest++ % REWIND_TURNS];
+	turn->state = *state;
+	turn->first = r->written;
+	turn->count = 0;
+}
+
+/*!*****************************************************************************
+	\brief	Add the changes of the journal to the newest turn and clear it
+
+	Call after everything else has read the journal. A reset journal can
+	not be taken back, so all turns are forgotten.
+
+	\param	r
+		Rewind buffer handler
+
+	\param	j
+		Journal of the playfield
+
+	\date	19.10.26
+*******************************************************************************/
+void keepChanges(struct rewindBuffer *r, struct journal *j) {
+	struct rewindTurn *turn;
+	int i;
+
+	if(j->reset) {
+		clearRewind(r);
+	}
+	for(i=r->skip; (i < j->count) && (r->newest != r->oldest); i++) {
+		// Make room by dropping whole turns, the newest one last
+		while((r->newest != r->oldest) && (r->written - r->turns[r->oldest % REWIND_TURNS].first >= REWIND_CHANGES)) {
+			r->oldest++;
+		}
+		if(r->newest == r->oldest) {
+			break;
+		}
+		turn = &r->turns[(r->newest - 1) % REWIND_TURNS];
+		r->changes[r->written++ % REWIND_CHANGES] = j->changes[i];
+		turn->count++;
+	}
+	r->skip = 0;
+	clearJournal(j);
+}
+
+/*!*****************************************************************************
+	\brief	Take back the newest turn
+
+	The cells are put back with setCell, so the journal of the board sees
+	them like any other change, but they are not kept as a turn.
+
+	\param	r
+		Rewind buffer handler
+
+	\param	b
+		Playfield, with its journal cleared by keepChanges
+
+	\param	state
+		Filled with the state before the turn
+
+	\return	0 on success, -1 if there is no turn to take back
+
+	\date	19.10.26
+*******************************************************************************/
+int rewindTurn(struct rewindBuffer *r, struct board *b, struct rewindState *state) {
+	const struct rewindTurn *turn;
+	const struct cellChange *change;
+	int i;
+
+	if(r->newest == r->oldest) {
+		return -1;
+	}
+	turn = &r->turns[--r->newest % REWIND_TURNS];
+	for(i=turn->count-1; i>=0; i--) {
+		change = &r->changes[(turn->first + i) % REWIND_CHANGES];
+		setCell(b, change->index % b->w, change->index / b->w, change->before);
+	}
+	r->written = turn->first;
+	*state = turn->state;
+	r->skip = (b->journal != NULL)? b->journal->count: 0;
+	return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "board.h"
+
+#define REWIND_TURNS 256
+#define REWIND_CHANGES (1 << 18)
+
+/*!*****************************************************************************
+	\brief	Everything besides the cells a turn changes
+
+	\date	19.10.26
+*******************************************************************************/
+struct rewindState {
+	int heroX, heroY;
+	int heroImage;
+	int killed;
+	int teleports;
+};
+
+/*!*****************************************************************************
+	\brief	One turn in the rewind buffer
+
+	The state is the one before the turn, the changes of the turn start at
+	first in the ring of changes.
+
+	\date	19.10.26
+*******************************************************************************/
+struct rewindTurn {
+	struct rewindState state;
+	unsigned int first;
+	int count;
+};
+
+/*!*****************************************************************************
+	\brief	Ring buffers of the latest turns and the cells they changed
+
+	Turns are counted from oldest up to newest, changes up to written. The
+	oldest turns are dropped when either ring is full, so a turn changing
+	more than REWIND_CHANGES cells can not be taken back.
+
+	\date	19.10.26
+*******************************************************************************/
+struct rewindBuffer {
+	struct rewindTurn turns[REWIND_TURNS];
+	unsigned int oldest, newest;
+	struct cellChange changes[REWIND_CHANGES];
+	unsigned int written;
+	int skip;
+};
+
+void clearRewind(struct rewindBuffer *r);
+void startTurn(struct rewindBuffer *r, const struct rewindState *state);
+void keepChanges(struct rewindBuffer *r, struct journal *j);
+int rewindTurn(struct rewindBuffer *r, struct board *b, struct rewindState *state);
+
+#endif
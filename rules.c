@@ -0,0 +1,246 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "rules.h"
+#include "kernels.h"
+
+/*!*****************************************************************************
+	\brief	Move all robots on a board one step towards the hero
+
+	Robots after the hero in reading order move first, then the ones before
+	it, so the crashes always happen the same way. If a robot catches the
+	hero, the board is left as it was at that moment. The standard field
+	sizes are moved by kernels built for their size.
+
+	\param	b
+		Board to move the robots on
+
+	\param	heroX, heroY
+		Position of the hero
+
+	\param	killed
+		Count of crashed robots to add to
+
+	\return	1 if a robot caught the hero, 0 otherwise
+
+	\date	19.10.26
+*******************************************************************************/
+int stepRobots(struct board *b, int heroX, int heroY, int *killed) {
+	stepKernel kernel = findStepKernel(b->w, b->h);
+	int x = heroX, y = heroY, move_x, move_y;
+
+	if(kernel != NULL) {
+		return kernel(b, heroX, heroY, killed);
+	}
+
+	for(;y<b->h;y++) {
+		for(;x<b->w;x++) {
+			if(CELL(b, x, y) == ROBOT) {
+				setCell(b, x, y, EMPTY);
+				move_x = (x < heroX)? x+1: (x > heroX)? x-1: x;
+				move_y = (y < heroY)? y+1: (y > heroY)? y-1: y;
+				if(CELL(b, move_x, move_y) == HERO) {
+					setCell(b, move_x, move_y, HERO_EXPLOSION); //TRASH;
+					return 1;
+				}
+				else if(CELL(b, move_x, move_y) != EMPTY) {
+					if(CELL(b, move_x, move_y) == MOVED_ROBOT) {
+						*killed+=2;
+					}
+					else {
+						(*killed)++;
+					}
+					setCell(b, move_x, move_y, EXPLOSION); //TRASH;
+				}
+				else {
+					setCell(b, move_x, move_y, MOVED_ROBOT);
+				}
+			}
+		}
+		x = 0;
+	}
+
+	x = heroX;
+	y = heroY;
+	for(;y>=0;y--) {
+		for(;x>=0;x--) {
+			if(CELL(b, x, y) == ROBOT) {
+				move_x = (x < heroX)? x+1: (x > heroX)? x-1: x;
+				move_y = (y < heroY)? y+1: (y > heroY)? y-1: y;
+				if(CELL(b, move_x, move_y) == HERO) {
+					setCell(b, move_x, move_y, HERO_EXPLOSION); //TRASH;
+					return 1;
+				}
+				else if(CELL(b, move_x, move_y) != EMPTY) {
+					if(CELL(b, move_x, move_y) == MOVED_ROBOT) {
+						*killed+=2;
+					}
+					else {
+						(*killed)++;
+					}
+					setCell(b, x, y, EMPTY);
+					setCell(b, move_x, move_y, EXPLOSION); //TRASH;
+				}
+				else
+				{
+					setCell(b, x, y, EMPTY);
+					setCell(b, move_x, move_y, MOVED_ROBOT);
+				}
+			}
+		}
+		x = b->w - 1;
+	}
+	for(x=0;x<b->w;x++) {
+		for(y=0;y<b->h;y++) {
+			if(CELL(b, x, y) == MOVED_ROBOT) {
+				setCell(b, x, y, ROBOT);
+			}
+			else if(CELL(b, x, y) == ROBOT) {
+				fprintf(stderr, "What? An unmoved robot?\n");
+			}
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Count the robots on a board
+
+	\param	b
+		Board to look at
+
+	\return	Robots that have not crashed
+
+	\date	19.10.26
+*******************************************************************************/
+int countRobots(const struct board *b) {
+	countKernel kernel = findCountKernel(b->w, b->h);
+	int i, robots = 0;
+
+	if(kernel != NULL) {
+		return kernel(b);
+	}
+	for(i=0; i<b->w*b->h; i++) {
+		robots += b->cells[i] == ROBOT;
+	}
+	return robots;
+}
+
+/*!*****************************************************************************
+	\brief	Add a cell to the explosions unless it is there already
+
+	\param	e
+		Explosions handler
+
+	\param	cell
+		Index of the cell
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+static int addExplosion(struct explosions *e, int cell) {
+	int *grown;
+	int i, size;
+
+	for(i=0; i<e->count; i++) {
+		if(e->cells[i] == cell) {
+			return 0;
+		}
+	}
+	if(e->count == e->size) {
+		size = e->size? e->size * 2: 64;
+		if((grown = realloc(e->cells, size * sizeof(*e->cells))) == NULL) {
+			return -1;
+		}
+		e->cells = grown;
+		e->size = size;
+	}
+	e->cells[e->count++] = cell;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Add the explosions made since the journal was last cleared
+
+	Must be called before the journal is cleared. A reset journal, or one
+	that cannot be followed, has the whole board looked at again.
+
+	\param	e
+		Explosions handler
+
+	\param	b
+		Board the journal is for
+
+	\param	j
+		Journal of the board
+
+	\date	19.10.26
+*******************************************************************************/
+void trackExplosions(struct explosions *e, const struct board *b, const struct journal *j) {
+	int i, cell;
+
+	if(!j->reset) {
+		for(i=0; i<j->count; i++) {
+			cell = j->changes[i].index;
+			if(((b->cells[cell] == EXPLOSION) || (b->cells[cell] == HERO_EXPLOSION)) && addExplosion(e, cell)) {
+				break;
+			}
+		}
+		if(i == j->count) {
+			return;
+		}
+	}
+	e->count = 0;
+	for(cell=0; cell<b->w*b->h; cell++) {
+		if((b->cells[cell] == EXPLOSION) || (b->cells[cell] == HERO_EXPLOSION)) {
+			addExplosion(e, cell);
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Let the explosions decay one step towards a hunkheap
+
+	Cells that still explode after the step are kept for the next one.
+
+	\param	e
+		Explosions handler
+
+	\param	b
+		Board of the explosions
+
+	\date	19.10.26
+*******************************************************************************/
+void decayExplosions(struct explosions *e, struct board *b) {
+	int i, cell, kept = 0;
+
+	for(i=0; i<e->count; i++) {
+		cell = e->cells[i];
+		if(b->cells[cell] == HERO_EXPLOSION) {
+			setCell(b, cell % b->w, cell / b->w, EXPLOSION);
+			e->cells[kept++] = cell;
+		}
+		else if(b->cells[cell] == EXPLOSION) {
+			setCell(b, cell % b->w, cell / b->w, TRASH);
+		}
+	}
+	e->count = kept;
+}
+
+/*!*****************************************************************************
+	\brief	Free the memory of the explosions
+
+	\param	e
+		Explosions handler
+
+	\date	19.10.26
+*******************************************************************************/
+void freeExplosions(struct explosions *e) {
+	free(e->cells);
+	memset(e, 0, sizeof(*e));
+}
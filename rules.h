@@ -0,0 +1,26 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "board.h"
+
+/*!*****************************************************************************
+	\brief	Cells of a board that hold an explosion
+
+	Kept up to date from the journal of the board, so the explosions can
+	decay without looking at every cell.
+
+	\date	19.10.26
+*******************************************************************************/
+struct explosions {
+	int *cells;
+	int count;
+	int size;
+};
+
+int stepRobots(struct board *b, int heroX, int heroY, int *killed);
+int countRobots(const struct board *b);
+void trackExplosions(struct explosions *e, const struct board *b, const struct journal *j);
+void decayExplosions(struct explosions *e, struct board *b);
+void freeExplosions(struct explosions *e);
+
+#endif
@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "scale.h"
+
+static struct spriteSet sets[SPRITE_SETS];
+static unsigned int useCount;
+
+/*!*****************************************************************************
+	\brief	Read one pixel of a 2 or 4 byte surface
+
+	\date	19.10.26
+*******************************************************************************/
+static Uint32 readPixel(const SDL_Surface *s, int x, int y) {
+	const Uint8 *p = (const Uint8 *)s->pixels + y * s->pitch + x * s->format->BytesPerPixel;
+	return (s->format->BytesPerPixel == 2)? *(const Uint16 *)p: *(const Uint32 *)p;
+}
+
+/*!*****************************************************************************
+	\brief	Write one pixel of a 2 or 4 byte surface
+
+	\date	19.10.26
+*******************************************************************************/
+static void writePixel(SDL_Surface *s, int x, int y, Uint32 pixel) {
+	Uint8 *p = (Uint8 *)s->pixels + y * s->pitch + x * s->format->BytesPerPixel;
+	if(s->format->BytesPerPixel == 2) {
+		*(Uint16 *)p = (Uint16)pixel;
+	}
+	else {
+		*(Uint32 *)p = pixel;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Scale the frames of a sprite sheet to a cell size
+
+	Each pixel gets the average of the sheet pixels it covers, weighted by
+	how much of each it covers, so shrinking does not drop detail the way
+	picking the nearest pixel does.
+
+	\param	sheet
+		Sheet with FIELD_WIDTH sized frames side by side
+
+	\param	cell
+		Size to scale each frame to
+
+	\return	Scaled sheet in the same pixel format, NULL on failure
+
+	\date	19.10.26
+*******************************************************************************/
+static SDL_Surface *scaleSheet(SDL_Surface *sheet, int cell) {
+	SDL_PixelFormat *format = sheet->format;
+	SDL_Surface *scaled;
+	int frames = sheet->w / FIELD_WIDTH, frame, x, y, u, v, left, right, top, bottom, wx, wy;
+	unsigned long r, g, b, weight;
+	Uint8 pr, pg, pb;
+
+	if((format->BytesPerPixel != 2) && (format->BytesPerPixel != 4)) {
+		return NULL;
+	}
+	if((scaled = SDL_CreateRGBSurface(SDL_SWSURFACE, frames * cell, cell, format->BitsPerPixel,
+		format->Rmask, format->Gmask, format->Bmask, format->Amask)) == NULL) {
+		return NULL;
+	}
+	if(SDL_MUSTLOCK(sheet)) {
+		SDL_LockSurface(sheet);
+	}
+	if(SDL_MUSTLOCK(scaled)) {
+		SDL_LockSurface(scaled);
+	}
+	// Sheet pixel u spans [u * cell, (u + 1) * cell) and cell pixel x spans
+	// [x * FIELD_WIDTH, (x + 1) * FIELD_WIDTH) in units of 1 / cell pixels
+	for(frame=0; frame<frames; frame++) {
+		for(y=0; y<cell; y++) {
+			for(x=0; x<cell; x++) {
+				r = g = b = weight = 0;
+				for(v=y * FIELD_WIDTH / cell; (v < FIELD_WIDTH) && (v * cell < (y + 1) * FIELD_WIDTH); v++) {
+					top = (v * cell > y * FIELD_WIDTH)? v * cell: y * FIELD_WIDTH;
+					bottom = ((v + 1) * cell < (y + 1) * FIELD_WIDTH)? (v + 1) * cell: (y + 1) * FIELD_WIDTH;
+					wy = bottom - top;
+					for(u=x * FIELD_WIDTH / cell; (u < FIELD_WIDTH) && (u * cell < (x + 1) * FIELD_WIDTH); u++) {
+						left = (u * cell > x * FIELD_WIDTH)? u * cell: x * FIELD_WIDTH;
+						right = ((u + 1) * cell < (x + 1) * FIELD_WIDTH)? (u + 1) * cell: (x + 1) * FIELD_WIDTH;
+						wx = right - left;
+						SDL_GetRGB(readPixel(sheet, frame * FIELD_WIDTH + u, v), format, &pr, &pg, &pb);
+						r += (unsigned long)pr * wx * wy;
+						g += (unsigned long)pg * wx * wy;
+						b += (unsigned long)pb * wx * wy;
+						weight += (unsigned long)wx * wy;
+					}
+				}
+				writePixel(scaled, frame * cell + x, y, SDL_MapRGB(scaled->format,
+					(Uint8)((r + weight / 2) / weight), (Uint8)((g + weight / 2) / weight), (Uint8)((b + weight / 2) / weight)));
+			}
+		}
+	}
+	if(SDL_MUSTLOCK(scaled)) {
+		SDL_UnlockSurface(scaled);
+	}
+	if(SDL_MUSTLOCK(sheet)) {
+		SDL_UnlockSurface(sheet);
+	}
+	return scaled;
+}
+
+/*!*****************************************************************************
+	\brief	Free the sheets of one set
+
+	\date	19.10.26
+*******************************************************************************/
+static void freeSet(struct spriteSet *set) {
+	int i;
+
+	for(i=0; i<SHEETS; i++) {
+		if(set->sheet[i] != NULL) {
+			SDL_FreeSurface(set->sheet[i]);
+		}
+	}
+	memset(set, 0, sizeof(*set));
+}
+
+/*!*****************************************************************************
+	\brief	Get the sprites scaled to a cell size
+
+	Sprites are scaled once per size and kept. When all SPRITE_SETS sets
+	are taken, the one used longest ago is dropped. Must be called from
+	the drawing thread only, never while bands are being drawn.
+
+	\param	cell
+		Size of a cell in pixels
+
+	\return	Sprite set, NULL if the sprites could not be scaled
+
+	\date	19.10.26
+*******************************************************************************/
+const struct spriteSet *spriteSet(int cell) {
+	SDL_Surface *sources[SHEETS];
+	struct spriteSet *set = &sets[0];
+	int i;
+
+	for(i=0; i<SPRITE_SETS; i++) {
+		if(sets[i].cell == cell) {
+			sets[i].used = ++useCount;
+			return &sets[i];
+		}
+		if(sets[i].used < set->used) {
+			set = &sets[i];
+		}
+	}
+	freeSet(set);
+	sources[SHEET_ROBOT] = robot;
+	sources[SHEET_HERO] = hero;
+	sources[SHEET_TRASH] = trash;
+	for(i=0; i<SHEETS; i++) {
+		if((set->sheet[i] = scaleSheet(sources[i], cell)) == NULL) {
+			freeSet(set);
+			return NULL;
+		}
+	}
+	set->cell = cell;
+	set->used = ++useCount;
+	return set;
+}
+
+/*!*****************************************************************************
+	\brief	Move a frame rectangle of an original sheet to a scaled sheet
+
+	\param	rect
+		Frame on the original sheet, changed to the frame on the scaled one
+
+	\param	cell
+		Cell size of the scaled sheet
+
+	\date	19.10.26
+*******************************************************************************/
+void spriteRect(SDL_Rect *rect, int cell) {
+	initRectangle(rect, rect->x / FIELD_WIDTH * cell, 0, cell, cell);
+}
+
+/*!*****************************************************************************
+	\brief	Free all scaled sprites
+
+	\date	19.10.26
+*******************************************************************************/
+void freeSpriteSets(void) {
+	int i;
+
+	for(i=0; i<SPRITE_SETS; i++) {
+		freeSet(&sets[i]);
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef SCALE_H
+#define SCALE_H
+
+#include "sdl.h"
+#include "render.h"
+
+#define SPRITE_SETS 8
+
+/*!*****************************************************************************
+	\brief	Sprite sheets scaled to one cell size
+
+	Every sheet has its frames side by side, frame i at x = i * cell.
+
+	\date	19.10.26
+*******************************************************************************/
+struct spriteSet {
+	int cell;
+	unsigned int used;
+	SDL_Surface *sheet[SHEETS];
+};
+
+const struct spriteSet *spriteSet(int cell);
+void spriteRect(SDL_Rect *rect, int cell);
+void freeSpriteSets(void);
+
+#endif
@@ -0,0 +1,563 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "scores.h"
+
+static const char *policyNames[SCORE_POLICIES] = { "human", "replay", "bot" };
+
+/*!*****************************************************************************
+	\brief	Compare two scores, the better one first
+
+	More robots killed wins, then the higher level, then the earlier game.
+
+	\date	19.10.26
+*******************************************************************************/
+static int compareBest(const void *a, const void *b) {
+	const struct scoreKey *x = (const struct scoreKey *)a, *y = (const struct scoreKey *)b;
+
+	if(x->killed != y->killed) {
+		return (x->killed > y->killed)? -1: 1;
+	}
+	if(x->level != y->level) {
+		return (x->level > y->level)? -1: 1;
+	}
+	return (x->record < y->record)? -1: (x->record > y->record)? 1: 0;
+}
+
+/*!*****************************************************************************
+	\brief	Compare two scores by policy first, then the better one first
+
+	\date	19.10.26
+*******************************************************************************/
+static int compareScores(const void *a, const void *b) {
+	const struct scoreKey *x = (const struct scoreKey *)a, *y = (const struct scoreKey *)b;
+
+	if(x->policy != y->policy) {
+		return (x->policy < y->policy)? -1: 1;
+	}
+	return compareBest(a, b);
+}
+
+/*!*****************************************************************************
+	\brief	Compare two seed keys
+
+	\date	19.10.26
+*******************************************************************************/
+static int compareSeeds(const void *a, const void *b) {
+	const struct seedKey *x = (const struct seedKey *)a, *y = (const struct seedKey *)b;
+
+	if(x->seed != y->seed) {
+		return (x->seed < y->seed)? -1: 1;
+	}
+	return (x->record < y->record)? -1: (x->record > y->record)? 1: 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get the score key of a record
+
+	\param	record
+		Result of a game
+
+	\param	number
+		Place of the record in the log
+
+	\date	19.10.26
+*******************************************************************************/
+static struct scoreKey keyOf(const struct scoreRecord *record, int number) {
+	struct scoreKey key;
+
+	key.policy = record->policy;
+	key.killed = record->killed;
+	key.level = record->level;
+	key.record = (uint32_t)number;
+	return key;
+}
+
+/*!*****************************************************************************
+	\brief	Read one record from the log or from the records not yet indexed
+
+	\param	s
+		Score store handler
+
+	\param	number
+		Place of the record in the log
+
+	\param	out
+		Record to fill
+
+	\return	0 on success, -1 on a read error
+
+	\date	19.10.26
+*******************************************************************************/
+static int readRecord(struct scoreStore *s, uint32_t number, struct scoreRecord *out) {
+	if(number >= (uint32_t)s->indexed) {
+		*out = s->tail[number - s->indexed];
+		return 0;
+	}
+	if(fseek(s->log, (long)(sizeof(struct scoreHeader) + (size_t)number * sizeof(*out)), SEEK_SET) ||
+		(fread(out, sizeof(*out), 1, s->log) != 1)) {
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Merge sorted keys into a sorted array from the back
+
+	\param	keys
+		Sorted array with room for extra more keys
+
+	\param	count
+		Keys in the array
+
+	\param	more
+		Sorted keys to merge in
+
+	\param	extra
+		Keys to merge in
+
+	\param	size
+		Size of one key
+
+	\param	compare
+		Order of the keys
+
+	\date	19.10.26
+*******************************************************************************/
+static void mergeSorted(char *keys, int count, const char *more, int extra, size_t size, int (*compare)(const void *, const void *)) {
+	int i = count - 1, j = extra - 1, at = count + extra - 1;
+
+	for(; j>=0; at--) {
+		if((i >= 0) && (compare(keys + i * size, more + j * size) > 0)) {
+			memcpy(keys + at * size, keys + i * size, size);
+			i--;
+		}
+		else {
+			memcpy(keys + at * size, more + j * size, size);
+			j--;
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Move the records kept in memory into the index
+
+	\param	s
+		Score store handler
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+static int mergeTail(struct scoreStore *s) {
+	struct scoreKey *scores, *grownScores;
+	struct seedKey *seeds, *grownSeeds;
+	int i, p, size;
+
+	if(!s->tailCount) {
+		return 0;
+	}
+	if(s->indexed + s->tailCount > s->size) {
+		for(size=s->size? s->size: SCORE_TAIL; size<s->indexed+s->tailCount; size*=2);
+		if((grownScores = realloc(s->byScore, size * sizeof(*s->byScore))) == NULL) {
+			return -1;
+		}
+		s->byScore = grownScores;
+		if((grownSeeds = realloc(s->bySeed, size * sizeof(*s->bySeed))) == NULL) {
+			return -1;
+		}
+		s->bySeed = grownSeeds;
+		s->size = size;
+	}
+	scores = malloc(s->tailCount * sizeof(*scores));
+	seeds = malloc(s->tailCount * sizeof(*seeds));
+	if((scores == NULL) || (seeds == NULL)) {
+		free(scores);
+		free(seeds);
+		return -1;
+	}
+	for(i=0; i<s->tailCount; i++) {
+		scores[i] = keyOf(&s->tail[i], s->indexed + i);
+		seeds[i].seed = s->tail[i].seed;
+		seeds[i].record = (uint32_t)(s->indexed + i);
+		seeds[i].unused = 0;
+		for(p=scores[i].policy; p<SCORE_POLICIES; p++) {
+			s->policyEnd[p]++;
+		}
+	}
+	qsort(scores, s->tailCount, sizeof(*scores), compareScores);
+	qsort(seeds, s->tailCount, sizeof(*seeds), compareSeeds);
+	mergeSorted((char *)s->byScore, s->indexed, (const char *)scores, s->tailCount, sizeof(*scores), compareScores);
+	mergeSorted((char *)s->bySeed, s->indexed, (const char *)seeds, s->tailCount, sizeof(*seeds), compareSeeds);
+	free(scores);
+	free(seeds);
+	s->indexed += s->tailCount;
+	s->tailCount = 0;
+	s->changed = 1;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Read the index of the log
+
+	A missing, broken or out of date index leaves the store empty, and the
+	records are indexed again from the log.
+
+	\param	s
+		Score store handler
+
+	\param	records
+		Records in the log
+
+	\date	19.10.26
+*******************************************************************************/
+static void loadIndex(struct scoreStore *s, int records) {
+	struct scoreIndexHeader header;
+	FILE *fp;
+	int p, broken;
+
+	if((fp = fopen(s->indexPath, "rb")) == NULL) {
+		return;
+	}
+	broken = (fread(&header, sizeof(header), 1, fp) != 1) || (header.magic != SCORE_INDEX_MAGIC) ||
+		(header.version != SCORE_VERSION) || (header.count > (uint32_t)records) ||
+		(header.policyEnd[SCORE_POLICIES - 1] != header.count);
+	for(p=1; !broken && (p<SCORE_POLICIES); p++) {
+		broken = header.policyEnd[p - 1] > header.policyEnd[p];
+	}
+	if(!broken && header.count) {
+		s->byScore = malloc(header.count * sizeof(*s->byScore));
+		s->bySeed = malloc(header.count * sizeof(*s->bySeed));
+		broken = (s->byScore == NULL) || (s->bySeed == NULL) ||
+			(fread(s->byScore, sizeof(*s->byScore), header.count, fp) != header.count) ||
+			(fread(s->bySeed, sizeof(*s->bySeed), header.count, fp) != header.count);
+	}
+	fclose(fp);
+	if(broken) {
+		fprintf(stderr, "Score index %s is made again\n", s->indexPath);
+		free(s->byScore);
+		free(s->bySeed);
+		s->byScore = NULL;
+		s->bySeed = NULL;
+		return;
+	}
+	s->indexed = s->size = (int)header.count;
+	for(p=0; p<SCORE_POLICIES; p++) {
+		s->policyEnd[p] = (int)header.policyEnd[p];
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Write the index next to the log
+
+	Written to a new file first and renamed over the old one, like the
+	level cache.
+
+	\param	s
+		Score store handler
+
+	\return	0 on success, -1 on a write error
+
+	\date	19.10.26
+*******************************************************************************/
+static int saveIndex(struct scoreStore *s) {
+	struct scoreIndexHeader header;
+	char *temporary;
+	FILE *fp;
+	int p, failed;
+
+	if((temporary = malloc(strlen(s->indexPath) + 5)) == NULL) {
+		return -1;
+	}
+	sprintf(temporary, "%s.new", s->indexPath);
+	if((fp = fopen(temporary, "wb")) == NULL) {
+		perror(temporary);
+		free(temporary);
+		return -1;
+	}
+	header.magic = SCORE_INDEX_MAGIC;
+	header.version = SCORE_VERSION;
+	header.count = (uint32_t)s->indexed;
+	for(p=0; p<SCORE_POLICIES; p++) {
+		header.policyEnd[p] = (uint32_t)s->policyEnd[p];
+	}
+	failed = (fwrite(&header, sizeof(header), 1, fp) != 1) ||
+		(fwrite(s->byScore, sizeof(*s->byScore), s->indexed, fp) != (size_t)s->indexed) ||
+		(fwrite(s->bySeed, sizeof(*s->bySeed), s->indexed, fp) != (size_t)s->indexed);
+	failed |= fclose(fp) != 0;
+	if(failed || rename(temporary, s->indexPath)) {
+		perror(s->indexPath);
+		remove(temporary);
+		free(temporary);
+		return -1;
+	}
+	free(temporary);
+	s->changed = 0;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Open a score log, creating it if it is missing
+
+	The index is read from the log name followed by .idx. Records written
+	after it are indexed again, and a record cut short by a crash is
+	dropped.
+
+	\param	s
+		Score store handler
+
+	\param	path
+		Log file
+
+	\return	0 on success, -1 if the log is broken or out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int openScores(struct scoreStore *s, const char *path) {
+	struct scoreHeader header = { SCORE_MAGIC, SCORE_VERSION, { 0, 0 } };
+	long length;
+	int records, number;
+
+	memset(s, 0, sizeof(*s));
+	if(((s->log = fopen(path, "a+b")) == NULL) || fseek(s->log, 0, SEEK_END) || ((length = ftell(s->log)) < 0)) {
+		perror(path);
+		closeScores(s);
+		return -1;
+	}
+	if(!length) {
+		if((fwrite(&header, sizeof(header), 1, s->log) != 1) || fflush(s->log)) {
+			perror(path);
+			closeScores(s);
+			return -1;
+		}
+		length = sizeof(header);
+	}
+	rewind(s->log);
+	if((fread(&header, sizeof(header), 1, s->log) != 1) || (header.magic != SCORE_MAGIC) || (header.version != SCORE_VERSION)) {
+		fprintf(stderr, "Score log %s is not for this game\n", path);
+		closeScores(s);
+		return -1;
+	}
+	records = (int)((length - (long)sizeof(header)) / (long)sizeof(struct scoreRecord));
+	if((long)sizeof(header) + (long)records * (long)sizeof(struct scoreRecord) != length) {
+		if(ftruncate(fileno(s->log), (long)sizeof(header) + (long)records * (long)sizeof(struct scoreRecord))) {
+			perror(path);
+			closeScores(s);
+			return -1;
+		}
+	}
+	if(((s->indexPath = malloc(strlen(path) + 5)) == NULL) || ((s->tail = malloc(SCORE_TAIL * sizeof(*s->tail))) == NULL)) {
+		closeScores(s);
+		return -1;
+	}
+	sprintf(s->indexPath, "%s.idx", path);
+	loadIndex(s, records);
+	if(fseek(s->log, (long)(sizeof(header) + (size_t)s->indexed * sizeof(struct scoreRecord)), SEEK_SET)) {
+		perror(path);
+		closeScores(s);
+		return -1;
+	}
+	for(number=s->indexed; number<records; number++) {
+		if(s->tailCount == SCORE_TAIL) {
+			if(mergeTail(s)) {
+				closeScores(s);
+				return -1;
+			}
+			fseek(s->log, (long)(sizeof(header) + (size_t)number * sizeof(struct scoreRecord)), SEEK_SET);
+		}
+		if((fread(&s->tail[s->tailCount], sizeof(*s->tail), 1, s->log) != 1) ||
+			(s->tail[s->tailCount].policy < 0) || (s->tail[s->tailCount].policy >= SCORE_POLICIES)) {
+			fprintf(stderr, "Score log %s is broken\n", path);
+			closeScores(s);
+			return -1;
+		}
+		s->tailCount++;
+		s->changed = 1;
+	}
+	s->summary.games = s->indexed + s->tailCount;
+	if((s->summary.count = topScores(s, -1, SCORE_TOP, s->summary.best)) < 0) {
+		closeScores(s);
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Append the result of a game to the log
+
+	\param	s
+		Score store handler
+
+	\param	record
+		Result of the game
+
+	\return	0 on success, -1 on a write error or if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int addScore(struct scoreStore *s, const struct scoreRecord *record) {
+	struct scoreKey key, other;
+	int at;
+
+	if((record->policy < 0) || (record->policy >= SCORE_POLICIES) || ((s->tailCount == SCORE_TAIL) && mergeTail(s))) {
+		return -1;
+	}
+	if(fseek(s->log, 0, SEEK_END) || (fwrite(record, sizeof(*record), 1, s->log) != 1) || fflush(s->log)) {
+		perror("Score log");
+		return -1;
+	}
+	s->tail[s->tailCount++] = *record;
+	s->changed = 1;
+	// The newest game never ties ahead of an older one
+	s->summary.games++;
+	key = keyOf(record, s->summary.games - 1);
+	for(at=s->summary.count; at>0; at--) {
+		other = keyOf(&s->summary.best[at - 1], 0);
+		if(compareBest(&other, &key) <= 0) {
+			break;
+		}
+		if(at < SCORE_TOP) {
+			s->summary.best[at] = s->summary.best[at - 1];
+		}
+	}
+	if(at < SCORE_TOP) {
+		s->summary.best[at] = *record;
+		s->summary.count += s->summary.count < SCORE_TOP;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get the best results of a policy or of all policies
+
+	Only the first k scores of each policy in the index can be among the
+	best, so the work does not grow with the log.
+
+	\param	s
+		Score store handler
+
+	\param	policy
+		Policy to look at, -1 for all of them
+
+	\param	k
+		Results wanted
+
+	\param	out
+		Room for k records, best first
+
+	\return	Records found, -1 on a read error or if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int topScores(struct scoreStore *s, int policy, int k, struct scoreRecord *out) {
+	struct scoreKey *candidates;
+	int i, p, start, count = 0;
+
+	if(k <= 0) {
+		return 0;
+	}
+	if((candidates = malloc(((size_t)SCORE_POLICIES * k + s->tailCount) * sizeof(*candidates))) == NULL) {
+		return -1;
+	}
+	for(p=0; p<SCORE_POLICIES; p++) {
+		start = p? s->policyEnd[p - 1]: 0;
+		for(i=start; ((policy < 0) || (policy == p)) && (i < s->policyEnd[p]) && (i < start + k); i++) {
+			candidates[count++] = s->byScore[i];
+		}
+	}
+	for(i=0; i<s->tailCount; i++) {
+		if((policy < 0) || (policy == s->tail[i].policy)) {
+			candidates[count++] = keyOf(&s->tail[i], s->indexed + i);
+		}
+	}
+	qsort(candidates, count, sizeof(*candidates), compareBest);
+	count = (count < k)? count: k;
+	for(i=0; i<count; i++) {
+		if(readRecord(s, candidates[i].record, &out[i])) {
+			count = -1;
+			break;
+		}
+	}
+	free(candidates);
+	return count;
+}
+
+/*!*****************************************************************************
+	\brief	Get the results of games played on a seed, oldest first
+
+	\param	s
+		Score store handler
+
+	\param	seed
+		Seed of the games
+
+	\param	k
+		Results wanted at most
+
+	\param	out
+		Room for k records
+
+	\return	Records found, -1 on a read error
+
+	\date	19.10.26
+*******************************************************************************/
+int seedScores(struct scoreStore *s, uint64_t seed, int k, struct scoreRecord *out) {
+	int low = 0, high = s->indexed, middle, i, count = 0;
+
+	while(low < high) {
+		middle = (low + high) / 2;
+		if(s->bySeed[middle].seed < seed) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	for(i=low; (i < s->indexed) && (s->bySeed[i].seed == seed) && (count < k); i++) {
+		if(readRecord(s, s->bySeed[i].record, &out[count++])) {
+			return -1;
+		}
+	}
+	for(i=0; (i < s->tailCount) && (count < k); i++) {
+		if(s->tail[i].seed == seed) {
+			out[count++] = s->tail[i];
+		}
+	}
+	return count;
+}
+
+/*!*****************************************************************************
+	\brief	Index the new records, write the index and close the log
+
+	\param	s
+		Score store handler
+
+	\date	19.10.26
+*******************************************************************************/
+void closeScores(struct scoreStore *s) {
+	if((s->log != NULL) && (s->indexPath != NULL) && s->changed && !mergeTail(s)) {
+		saveIndex(s);
+	}
+	if(s->log != NULL) {
+		fclose(s->log);
+	}
+	free(s->indexPath);
+	free(s->byScore);
+	free(s->bySeed);
+	free(s->tail);
+	memset(s, 0, sizeof(*s));
+}
+
+/*!*****************************************************************************
+	\brief	Get the name of a policy
+
+	\param	policy
+		Enum policy value
+
+	\date	19.10.26
+*******************************************************************************/
+const char *policyName(int policy) {
+	return ((policy >= 0) && (policy < SCORE_POLICIES))? policyNames[policy]: "?";
+}
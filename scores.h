@@ -0,0 +1,131 @@
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define SCORE_MAGIC	0x52435352
+#define SCORE_INDEX_MAGIC	0x58435352
+#define SCORE_VERSION	1
+#define SCORE_TAIL	4096
+#define SCORE_TOP	3
+#define SCORE_LIST	10
+
+/*!*****************************************************************************
+	\brief	Who played a game
+
+	\date	19.10.26
+*******************************************************************************/
+enum {
+	POLICY_HUMAN=0,
+	POLICY_REPLAY,
+	POLICY_BOT,
+	SCORE_POLICIES,
+};
+
+/*!*****************************************************************************
+	\brief	Start of the score log, followed by records up to the end
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t unused[2];
+};
+
+/*!*****************************************************************************
+	\brief	Result of one game as stored in the log
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreRecord {
+	uint64_t seed;
+	int32_t w, h;
+	int32_t level;
+	int32_t killed;
+	int32_t policy;
+	uint32_t unused;
+};
+
+/*!*****************************************************************************
+	\brief	Start of the index file, followed by count score keys and count
+	seed keys
+
+	Score keys are grouped by policy, the group of a policy ends at its
+	policyEnd.
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreIndexHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t policyEnd[SCORE_POLICIES];
+};
+
+/*!*****************************************************************************
+	\brief	Score of a record, sorted best first within its policy
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreKey {
+	int32_t policy;
+	int32_t killed;
+	int32_t level;
+	uint32_t record;
+};
+
+/*!*****************************************************************************
+	\brief	Seed of a record, sorted by seed and then by record
+
+	\date	19.10.26
+*******************************************************************************/
+struct seedKey {
+	uint64_t seed;
+	uint32_t record;
+	uint32_t unused;
+};
+
+/*!*****************************************************************************
+	\brief	Games played and the best of them, kept up to date on every score
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreSummary {
+	int games;
+	int count;
+	struct scoreRecord best[SCORE_TOP];
+};
+
+/*!*****************************************************************************
+	\brief	Append-only score log with its index
+
+	The index covers the first indexed records of the log, the records
+	after them are kept in memory until there are SCORE_TAIL of them and
+	they are merged into the index. Only one game at a time may add scores.
+
+	\date	19.10.26
+*******************************************************************************/
+struct scoreStore {
+	FILE *log;
+	char *indexPath;
+	struct scoreKey *byScore;
+	struct seedKey *bySeed;
+	int indexed;
+	int size;
+	int policyEnd[SCORE_POLICIES];
+	struct scoreRecord *tail;
+	int tailCount;
+	int changed;
+	struct scoreSummary summary;
+};
+
+int openScores(struct scoreStore *s, const char *path);
+int addScore(struct scoreStore *s, const struct scoreRecord *record);
+int topScores(struct scoreStore *s, int policy, int k, struct scoreRecord *out);
+int seedScores(struct scoreStore *s, uint64_t seed, int k, struct scoreRecord *out);
+void closeScores(struct scoreStore *s);
+const char *policyName(int policy);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SDL_COMPAT_H
+#define SDL_COMPAT_H
+
+/*
+	The game is written for SDL 1.2. Built with USE_SDL2 it uses SDL2
+	instead, and the few SDL 1.2 names it needs are mapped here.
+*/
+
+#ifdef USE_SDL2
+#include "SDL2/SDL.h"
+#include "SDL2/SDL_ttf.h"
+
+typedef SDL_Keycode SDLKey;
+
+#define SDLK_KP0	SDLK_KP_0
+#define SDLK_KP1	SDLK_KP_1
+#define SDLK_KP2	SDLK_KP_2
+#define SDLK_KP3	SDLK_KP_3
+#define SDLK_KP4	SDLK_KP_4
+#define SDLK_KP5	SDLK_KP_5
+#define SDLK_KP6	SDLK_KP_6
+#define SDLK_KP7	SDLK_KP_7
+#define SDLK_KP8	SDLK_KP_8
+#define SDLK_KP9	SDLK_KP_9
+
+#define SDL_CreateThread(fn, data)	SDL_CreateThread(fn, "robots", data)
+#else
+#include "SDL/SDL.h"
+#include "SDL/SDL_ttf.h"
+#endif
+
+#endif
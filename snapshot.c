@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "snapshot.h"
+
+/*!*****************************************************************************
+	\brief	Map a snapshot file to memory and check it
+
+	A missing file is no snapshot, and leaves the header NULL. The hero
+	must be on its cell, alive or exploding, and on no other cell.
+
+	\param	s
+		Snapshot handler
+
+	\param	path
+		File to map
+
+	\return	0 on success, -1 if the file is broken
+
+	\date	19.10.26
+*******************************************************************************/
+int openSnapshot(struct snapshot *s, const char *path) {
+	const struct snapshotHeader *header;
+	struct stat info;
+	size_t i, cells, hero;
+	int fd;
+
+	memset(s, 0, sizeof(*s));
+	if((fd = open(path, O_RDONLY)) < 0) {
+		return 0;
+	}
+	if(fstat(fd, &info) || (info.st_size < (off_t)sizeof(*header)) ||
+		((s->mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)) {
+		fprintf(stderr, "Couldn't map %s\n", path);
+		s->mapped = NULL;
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	s->size = (size_t)info.st_size;
+	header = s->mapped;
+	cells = (size_t)header->w * header->h;
+	if((header->magic != SNAPSHOT_MAGIC) || (header->version != SNAPSHOT_VERSION) ||
+		(header->w < 2) || (header->h < 2) || (s->size != sizeof(*header) + cells) ||
+		(header->heroX < 0) || (header->heroY < 0) || (header->heroX >= header->w) || (header->heroY >= header->h) ||
+		(header->currentLevel < 1) || (header->robotCount < 0) || (header->safeTeleports < 0)) {
+		fprintf(stderr, "Snapshot %s is not for this game\n", path);
+		closeSnapshot(s);
+		return -1;
+	}
+	s->cells = (const char *)(header + 1);
+	hero = (size_t)header->heroY * header->w + header->heroX;
+	for(i=0; i<cells; i++) {
+		// The hero is on its own cell and nowhere else
+		if((s->cells[i] < EMPTY) || (s->cells[i] > HERO_EXPLOSION) ||
+			(((s->cells[i] == HERO) || (s->cells[i] == HERO_EXPLOSION)) != (i == hero))) {
+			fprintf(stderr, "Snapshot %s is broken\n", path);
+			closeSnapshot(s);
+			return -1;
+		}
+	}
+	s->header = header;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Put the cells of a snapshot on a board of the same size
+
+	\param	s
+		Snapshot handler
+
+	\param	b
+		Board to put the cells on
+
+	\date	19.10.26
+*******************************************************************************/
+void restoreSnapshot(const struct snapshot *s, struct board *b) {
+	struct board mapped;
+
+	memset(&mapped, 0, sizeof(mapped));
+	mapped.w = s->header->w;
+	mapped.h = s->header->h;
+	mapped.cells = (char *)s->cells;
+	copyWindow(b, &mapped, 0, 0);
+}
+
+/*!*****************************************************************************
+	\brief	Unmap a snapshot file
+
+	\param	s
+		Snapshot handler
+
+	\date	19.10.26
+*******************************************************************************/
+void closeSnapshot(struct snapshot *s) {
+	if(s->mapped != NULL) {
+		munmap(s->mapped, s->size);
+	}
+	memset(s, 0, sizeof(*s));
+}
+
+/*!*****************************************************************************
+	\brief	Write a snapshot of a game to a file
+
+	The snapshot is written next to the file, flushed to the disk and then
+	renamed over it, so a game stopped at any point leaves either the old
+	snapshot or the new one.
+
+	\param	path
+		File to write
+
+	\param	header
+		State of the game, with the magic and version set here
+
+	\param	b
+		Field of the game
+
+	\return	0 on success, -1 on a write error
+
+	\date	19.10.26
+*******************************************************************************/
+int saveSnapshot(const char *path, const struct snapshotHeader *header, const struct board *b) {
+	struct snapshotHeader written = *header;
+	size_t cells = (size_t)b->w * b->h;
+	char *temporary;
+	FILE *fp;
+	int failed;
+
+	if((temporary = malloc(strlen(path) + 5)) == NULL) {
+		return -1;
+	}
+	sprintf(temporary, "%s.new", path);
+	if((fp = fopen(temporary, "wb")) == NULL) {
+		perror(temporary);
+		free(temporary);
+		return -1;
+	}
+	written.magic = SNAPSHOT_MAGIC;
+	written.version = SNAPSHOT_VERSION;
+	written.w = b->w;
+	written.h = b->h;
+	failed = (fwrite(&written, sizeof(written), 1, fp) != 1) ||
+		(fwrite(b->cells, 1, cells, fp) != cells) ||
+		(fflush(fp) != 0) || (fsync(fileno(fp)) != 0);
+	failed |= fclose(fp) != 0;
+	if(failed || rename(temporary, path)) {
+		perror(path);
+		remove(temporary);
+		free(temporary);
+		return -1;
+	}
+	free(temporary);
+	return 0;
+}
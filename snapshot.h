@@ -0,0 +1,55 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "board.h"
+
+#define SNAPSHOT_MAGIC	0x50534E52
+#define SNAPSHOT_VERSION	1
+#define SNAPSHOT_INTERVAL	10000	// ms of game time between checkpoints of a capture
+
+/*!*****************************************************************************
+	\brief	Start of a snapshot file, followed by the w x h cells of the field
+
+	Holds everything of a game in progress besides the field, the random
+	state included, so a resumed game goes on the same way.
+
+	\date	19.10.26
+*******************************************************************************/
+struct snapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	int32_t w, h;
+	int32_t heroX, heroY;
+	int32_t heroImage;
+	int32_t updateMovement;
+	int32_t currentLevel;
+	int32_t robotCount;
+	int32_t safeTeleports;
+	int32_t robotsKilled;
+	uint64_t randomState;
+	uint64_t gameSeed;
+	uint32_t advisedTurns;
+	uint32_t unused;
+};
+
+/*!*****************************************************************************
+	\brief	Snapshot file mapped to memory
+
+	\date	19.10.26
+*******************************************************************************/
+struct snapshot {
+	const struct snapshotHeader *header;
+	const char *cells;
+	void *mapped;
+	size_t size;
+};
+
+int openSnapshot(struct snapshot *s, const char *path);
+void restoreSnapshot(const struct snapshot *s, struct board *b);
+void closeSnapshot(struct snapshot *s);
+int saveSnapshot(const char *path, const struct snapshotHeader *header, const struct board *b);
+
+#endif
@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "rules.h"
+#include "pool.h"
+#include "level.h"
+#include "bot.h"
+#include "solver.h"
+
+/*!*****************************************************************************
+	\brief	One turn of the search, the field and the moves left to try
+
+	\date	19.10.26
+*******************************************************************************/
+struct solverTurn {
+	struct board board;
+	int heroX, heroY;
+	SDLKey order[9];
+	int moves;
+	int next;
+};
+
+/*!*****************************************************************************
+	\brief	Candidates of one round of the parallel search
+
+	\date	19.10.26
+*******************************************************************************/
+struct solverRound {
+	int number, robots;
+	int w, h;
+	unsigned long long seed[64];
+	int solved[64];
+};
+
+/*!*****************************************************************************
+	\brief	Get the moves worth trying from a turn, best first
+
+	Steps onto anything are left out. The rest are sorted by how far the
+	nearest robot is from where the hero ends up, and waiting comes first
+	of equally safe moves, as it lets the robots crash.
+
+	\param	t
+		Turn to sort the moves of
+
+	\date	19.10.26
+*******************************************************************************/
+static void orderMoves(struct solverTurn *t) {
+	static const SDLKey keys[9] = { SDLK_KP5, SDLK_KP1, SDLK_KP2, SDLK_KP3, SDLK_KP4, SDLK_KP6, SDLK_KP7, SDLK_KP8, SDLK_KP9 };
+	const struct board *b = &t->board;
+	int k, i, j, x, y, dx, dy, d, nearest, distance[9];
+
+	t->moves = 0;
+	t->next = 0;
+	for(k=0; k<9; k++) {
+		botStep(keys[k], &dx, &dy);
+		x = t->heroX + dx;
+		y = t->heroY + dy;
+		if((x < 0) || (y < 0) || (x >= b->w) || (y >= b->h) || ((keys[k] != SDLK_KP5) && (CELL(b, x, y) != EMPTY))) {
+			continue;
+		}
+		nearest = 3;
+		for(j=y-2; j<=y+2; j++) {
+			for(i=x-2; i<=x+2; i++) {
+				if((i < 0) || (j < 0) || (i >= b->w) || (j >= b->h) || (CELL(b, i, j) != ROBOT)) {
+					continue;
+				}
+				d = (abs(i - x) > abs(j - y))? abs(i - x): abs(j - y);
+				nearest = (d < nearest)? d: nearest;
+			}
+		}
+		// Insertion keeps waiting first of equally safe moves
+		for(j=t->moves; (j > 0) && (distance[j - 1] < nearest); j--) {
+			t->order[j] = t->order[j - 1];
+			distance[j] = distance[j - 1];
+		}
+		t->order[j] = keys[k];
+		distance[j] = nearest;
+		t->moves++;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Check if a level can be cleared without teleporting
+
+	Depth first search over the hero steps, with the robots moved by the
+	same rules as in the game.
+
+	\param	l
+		Level to solve, not changed
+
+	\param	turns
+		Most turns the solution may take
+
+	\param	nodes
+		Most turns to try in all
+
+	\return	1 if the level was solved, 0 if not or if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int solveLevel(const struct level *l, int turns, long nodes) {
+	struct solverTurn *t, *step;
+	int depth = 0, x, y, dx, dy, killed = 0, solved = 0, i;
+	SDLKey move;
+
+	if((step = calloc(turns + 1, sizeof(*step))) == NULL) {
+		return 0;
+	}
+	if(!createBoard(&step[0].board, l->board.w, l->board.h)) {
+		copyBoard(&step[0].board, &l->board);
+		step[0].heroX = l->heroX;
+		step[0].heroY = l->heroY;
+		orderMoves(&step[0]);
+	}
+	while((depth >= 0) && (step[0].board.cells != NULL)) {
+		t = &step[depth];
+		if((t->next == t->moves) || (depth == turns)) {
+			depth--;
+			continue;
+		}
+		if(--nodes < 0) {
+			break;
+		}
+		move = t->order[t->next++];
+		if((step[depth + 1].board.cells == NULL) && createBoard(&step[depth + 1].board, l->board.w, l->board.h)) {
+			break;
+		}
+		t = &step[depth + 1];
+		copyBoard(&t->board, &step[depth].board);
+		botStep(move, &dx, &dy);
+		x = step[depth].heroX + dx;
+		y = step[depth].heroY + dy;
+		setCell(&t->board, step[depth].heroX, step[depth].heroY, EMPTY);
+		setCell(&t->board, x, y, HERO);
+		if(stepRobots(&t->board, x, y, &killed)) {
+			continue;
+		}
+		if(memchr(t->board.cells, ROBOT, (size_t)t->board.w * t->board.h) == NULL) {
+			solved = 1;
+			break;
+		}
+		t->heroX = x;
+		t->heroY = y;
+		orderMoves(t);
+		depth++;
+	}
+	for(i=0; i<=turns; i++) {
+		freeBoard(&step[i].board);
+	}
+	free(step);
+	return solved;
+}
+
+/*!*****************************************************************************
+	\brief	Make and try to solve one candidate level of a round
+
+	\param	data
+		Round of the search
+
+	\param	index
+		Index of the candidate in the round
+
+	\date	19.10.26
+*******************************************************************************/
+static void solveCandidate(void *data, int index) {
+	struct solverRound *round = (struct solverRound *)data;
+	struct level l;
+
+	memset(&l, 0, sizeof(l));
+	l.number = round->number;
+	l.robots = round->robots;
+	l.seed = round->seed[index];
+	if(createBoard(&l.board, round->w, round->h)) {
+		return;
+	}
+	makeLevel(&l);
+	round->solved[index] = solveLevel(&l, SOLVER_TURNS, SOLVER_NODES);
+	freeBoard(&l.board);
+}
+
+/*!*****************************************************************************
+	\brief	Search for seeds that give a level solvable without teleports
+
+	Candidates are tried in rounds on all threads of the pool, but taken in
+	order, and the last round stops at SOLVER_TRIES, so the same level and
+	field size always give the same seeds on any number of cores.
+
+	\param	p
+		Pool to search on
+
+	\param	number, robots
+		Level to search for
+
+	\param	w, h
+		Size of the field
+
+	\param	wanted
+		Seeds to find
+
+	\param	seeds
+		Seeds found
+
+	\return	Amount of seeds found, less than wanted after SOLVER_TRIES tries
+
+	\date	19.10.26
+*******************************************************************************/
+int findSolvable(struct pool *p, int number, int robots, int w, int h, int wanted, unsigned long long *seeds) {
+	struct solverRound round;
+	unsigned long long state = ((unsigned long long)w << 40) ^ ((unsigned long long)h << 20) ^ (unsigned long long)number;
+	int found = 0, tried, jobs, i;
+
+	memset(&round, 0, sizeof(round));
+	round.number = number;
+	round.robots = robots;
+	round.w = w;
+	round.h = h;
+	for(tried=0; (tried < SOLVER_TRIES) && (found < wanted); tried+=jobs) {
+		jobs = (p->threads + 1) * 2;
+		jobs = (jobs > 64)? 64: jobs;
+		jobs = (jobs > SOLVER_TRIES - tried)? SOLVER_TRIES - tried: jobs;
+		for(i=0; i<jobs; i++) {
+			round.seed[i] = nextBits(&state);
+			round.solved[i] = 0;
+		}
+		runPool(p, jobs, solveCandidate, &round);
+		for(i=0; (i < jobs) && (found < wanted); i++) {
+			if(round.solved[i]) {
+				seeds[found++] = round.seed[i];
+			}
+		}
+	}
+	return found;
+}
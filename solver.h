@@ -0,0 +1,14 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "pool.h"
+#include "level.h"
+
+#define SOLVER_TURNS 256
+#define SOLVER_NODES 50000
+#define SOLVER_TRIES 512
+
+int solveLevel(const struct level *l, int turns, long nodes);
+int findSolvable(struct pool *p, int number, int robots, int w, int h, int wanted, unsigned long long *seeds);
+
+#endif
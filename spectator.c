@@ -0,0 +1,446 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "level.h"
+#include "danger.h"
+#include "rules.h"
+#include "bot.h"
+#include "pool.h"
+#include "render.h"
+#include "spectator.h"
+
+#define NEW_ROUND 4
+
+/*
+	Colour of each item in a thumbnail
+*/
+static const Uint32 itemColours[] = {
+	[EMPTY] = 0xFFFFFF,
+	[ROBOT] = 0x303030,
+	[HERO] = 0x2040FF,
+	[TRASH] = 0x806040,
+	[MOVED_ROBOT] = 0x303030,
+	[EXPLOSION] = 0xFF8000,
+	[HERO_EXPLOSION] = 0xFF0000,
+};
+
+/*!*****************************************************************************
+	\brief	Make the level the game is on and put the hero on it
+
+	\param	g
+		Game handler, with the level number and robots set
+
+	\date	19.10.26
+*******************************************************************************/
+static void startLevel(struct spectatorGame *g) {
+	g->level.seed = nextBits(&g->state);
+	makeLevel(&g->level);
+	g->heroX = g->level.heroX;
+	g->heroY = g->level.heroY;
+	g->over = 0;
+}
+
+/*!*****************************************************************************
+	\brief	Start a game from the first level, like resetPlayfield
+
+	\param	g
+		Game handler
+
+	\date	19.10.26
+*******************************************************************************/
+static void startGame(struct spectatorGame *g) {
+	g->level.number = 1;
+	g->level.robots = firstRobotCount();
+	g->teleports = 4;
+	g->killed = 0;
+	g->games++;
+	startLevel(g);
+}
+
+/*!*****************************************************************************
+	\brief	Play one turn of a game, job of the pool
+
+	A game that ended on the turn before starts again, a cleared level goes
+	on to the next one. Otherwise the bot picks the key and the turn goes
+	like in moveProgtagonist and moveRobots.
+
+	\param	data
+		Spectator handler
+
+	\param	index
+		Number of the game
+
+	\date	19.10.26
+*******************************************************************************/
+static void playTurn(void *data, int index) {
+	struct spectator *s = data;
+	struct spectatorGame *g = &s->game[index];
+	struct board *b = &g->level.board;
+	long long cell;
+	int x, y, dx, dy, teleport, tries;
+
+	if(g->over < 0) {
+		startGame(g);
+	}
+	else if(g->over > 0) {
+		g->level.number++;
+		g->level.robots = nextRobotCount(g->level.robots);
+		g->teleports += 2;
+		startLevel(g);
+	}
+	else {
+		trackExplosions(&g->explosions, b, &g->journal);
+		decayExplosions(&g->explosions, b);
+		updateDanger(&g->danger, b);
+		clearJournal(&g->journal);
+		if((teleport = botStep(botMove(&g->danger, b, g->heroX, g->heroY), &dx, &dy))) {
+			// Teleports land on an empty cell, on a full field the hero waits
+			x = g->heroX;
+			y = g->heroY;
+			for(tries=0; tries<64; tries++) {
+				cell = (long long)(nextBits(&g->state) % ((unsigned long long)b->w * b->h));
+				if(b->cells[cell] == EMPTY) {
+					x = (int)(cell % b->w);
+					y = (int)(cell / b->w);
+					break;
+				}
+			}
+		}
+		else {
+			x = g->heroX + dx;
+			y = g->heroY + dy;
+		}
+		setCell(b, g->heroX, g->heroY, EMPTY);
+		g->heroX = x;
+		g->heroY = y;
+		if(CELL(b, x, y) != EMPTY) {
+			setCell(b, x, y, HERO_EXPLOSION);
+			g->over = -1;
+		}
+		else {
+			setCell(b, x, y, HERO);
+			if(teleport && (g->teleports > 0)) {
+				g->teleports--;
+			}
+			else if(stepRobots(b, x, y, &g->killed)) {
+				g->over = -1;
+			}
+			else if(!countRobots(b)) {
+				g->over = 1;
+			}
+		}
+	}
+	g->version++;
+}
+
+/*!*****************************************************************************
+	\brief	Copy the games changed since the back slot was filled to it, and
+		swap it to the middle
+
+	\param	s
+		Spectator handler
+
+	\date	19.10.26
+*******************************************************************************/
+static void publishRound(struct spectator *s) {
+	struct mosaicSlot *slot = &s->slot[s->back];
+	size_t cells = (size_t)s->w * s->h;
+	int i, old;
+
+	for(i=0; i<s->games; i++) {
+		if(slot->versions[i] != s->game[i].version) {
+			memcpy(&slot->cells[i * cells], s->game[i].level.board.cells, cells);
+			slot->versions[i] = s->game[i].version;
+		}
+	}
+	old = __atomic_exchange_n(&s->middle, s->back | NEW_ROUND, __ATOMIC_ACQ_REL);
+	s->back = old & ~NEW_ROUND;
+}
+
+/*!*****************************************************************************
+	\brief	Play rounds of turns until told to quit
+
+	\param	data
+		Spectator handler
+
+	\date	19.10.26
+*******************************************************************************/
+static int spectatorWorker(void *data) {
+	struct spectator *s = data;
+
+	while(!__atomic_load_n(&s->quit, __ATOMIC_RELAXED)) {
+		runPool(s->pool, s->games, playTurn, s);
+		publishRound(s);
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Lay the thumbnails out on the window with the biggest cells
+
+	\return	0 on success, -1 if the cells of a thumbnail can not fit in one
+		pixel
+
+	\date	19.10.26
+*******************************************************************************/
+static int layMosaic(struct spectator *s, int windowW, int windowH) {
+	int columns, rows, scale, scaleY;
+
+	s->scale = 0;
+	for(columns=1; columns<=s->games; columns++) {
+		rows = (s->games + columns - 1) / columns;
+		scale = (windowW - SPECTATOR_GAP * (columns + 1)) / columns / s->w;
+		scaleY = (windowH - SPECTATOR_GAP * (rows + 1)) / rows / s->h;
+		scale = (scaleY < scale)? scaleY: scale;
+		if(scale > s->scale) {
+			s->scale = scale;
+			s->columns = columns;
+		}
+	}
+	if(s->scale < 1) {
+		return -1;
+	}
+	rows = (s->games + s->columns - 1) / s->columns;
+	s->left = (windowW - s->columns * (s->w * s->scale + SPECTATOR_GAP) + SPECTATOR_GAP) / 2;
+	s->top = (windowH - rows * (s->h * s->scale + SPECTATOR_GAP) + SPECTATOR_GAP) / 2;
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Start playing bot games on all cores but one
+
+	Every game gets a seed of its own from the seed given. The pool leaves
+	one core to the thread drawing the mosaic.
+
+	\param	s
+		Spectator handler
+
+	\param	games
+		Number of games
+
+	\param	w, h
+		Size of the field of every game
+
+	\param	windowW, windowH
+		Size of the window the mosaic is drawn on
+
+	\param	seed
+		Seed of the games
+
+	\return	0 on success, -1 on failure
+
+	\date	19.10.26
+*******************************************************************************/
+int startSpectator(struct spectator *s, int games, int w, int h, int windowW, int windowH, unsigned long long seed) {
+	size_t cells = (size_t)w * h;
+	int i;
+
+	memset(s, 0, sizeof(*s));
+	s->games = games;
+	s->w = w;
+	s->h = h;
+	if((games < 1) || (games > SPECTATOR_MAX_GAMES) || layMosaic(s, windowW, windowH)) {
+		fprintf(stderr, "Can't fit %d games of %dx%d on a %dx%d window\n", games, w, h, windowW, windowH);
+		return -1;
+	}
+	if(((s->game = calloc(games, sizeof(*s->game))) == NULL) ||
+		((s->drawn = malloc(games * sizeof(*s->drawn))) == NULL)) {
+		stopSpectator(s);
+		return -1;
+	}
+	for(i=0; i<3; i++) {
+		if(((s->slot[i].cells = calloc(games, cells)) == NULL) ||
+			((s->slot[i].versions = calloc(games, sizeof(*s->slot[i].versions))) == NULL)) {
+			stopSpectator(s);
+			return -1;
+		}
+	}
+	for(i=0; i<games; i++) {
+		if(createBoard(&s->game[i].level.board, w, h) || createDanger(&s->game[i].danger, w, h)) {
+			stopSpectator(s);
+			return -1;
+		}
+		s->game[i].level.board.journal = &s->game[i].journal;
+		s->game[i].state = seed ^ ((unsigned long long)(i + 1) * 0xD1B54A32D192ED03ULL);
+		startGame(&s->game[i]);
+	}
+	// Every thumbnail is drawn on the first frame
+	memset(s->drawn, 0xFF, games * sizeof(*s->drawn));
+	s->back = 0;
+	s->middle = 1;
+	s->front = 2;
+	for(i=0; i<(int)(sizeof(itemColours) / sizeof(itemColours[0])); i++) {
+		s->palette[i] = renderer->direct? SDL_MapRGB(screen->format, (itemColours[i] >> 16) & 0xFF, (itemColours[i] >> 8) & 0xFF, itemColours[i] & 0xFF): itemColours[i];
+	}
+	if(((s->pool = createPool(cpuCount() - 2)) == NULL) ||
+		((s->thread = SDL_CreateThread(spectatorWorker, s)) == NULL)) {
+		stopSpectator(s);
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Write the cells of one thumbnail straight to the screen
+
+	\param	s
+		Spectator handler
+
+	\param	cells
+		Cells of the game
+
+	\param	x, y
+		Top left corner of the thumbnail
+
+	\date	19.10.26
+*******************************************************************************/
+static void writeThumbnail(const struct spectator *s, const char *cells, int x, int y) {
+	int i, j, k, bytes = screen->format->BytesPerPixel;
+	Uint32 pixel;
+	Uint8 *row;
+
+	for(j=0; j<s->h * s->scale; j++) {
+		row = (Uint8 *)screen->pixels + (y + j) * screen->pitch + x * bytes;
+		for(i=0; i<s->w; i++) {
+			pixel = s->palette[(unsigned char)cells[i]];
+			for(k=0; k<s->scale; k++) {
+				if(bytes == 2) {
+					((Uint16 *)row)[i * s->scale + k] = (Uint16)pixel;
+				}
+				else {
+					((Uint32 *)row)[i * s->scale + k] = pixel;
+				}
+			}
+		}
+		if((j + 1) % s->scale == 0) {
+			cells += s->w;
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Fill the cells of one thumbnail through the renderer
+
+	The thumbnail is filled empty, and every run of the same item on a row
+	is one more fill.
+
+	\param	s
+		Spectator handler
+
+	\param	cells
+		Cells of the game
+
+	\param	x, y
+		Top left corner of the thumbnail
+
+	\date	19.10.26
+*******************************************************************************/
+static void fillThumbnail(const struct spectator *s, const char *cells, int x, int y) {
+	SDL_Rect rect;
+	int i, j, end;
+
+	initRectangle(&rect, x, y, s->w * s->scale, s->h * s->scale);
+	renderer->fill(&rect, s->palette[EMPTY]);
+	for(j=0; j<s->h; j++, cells+=s->w) {
+		for(i=0; i<s->w; i=end) {
+			for(end=i+1; (end < s->w) && (cells[end] == cells[i]); end++);
+			if(cells[i] != EMPTY) {
+				initRectangle(&rect, x + i * s->scale, y + j * s->scale, (end - i) * s->scale, s->scale);
+				renderer->fill(&rect, s->palette[(unsigned char)cells[i]]);
+			}
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Draw the latest round of the games
+
+	A renderer drawing straight to the screen keeps the thumbnails of the
+	frame before, so only the games changed since are drawn. Other
+	renderers draw every frame from scratch.
+
+	\param	s
+		Spectator handler
+
+	\return	Number of thumbnails drawn, 0 if there was no new round
+
+	\date	19.10.26
+*******************************************************************************/
+int drawMosaic(struct spectator *s) {
+	const struct mosaicSlot *slot;
+	size_t cells = (size_t)s->w * s->h;
+	int i, x, y, old, drawn = 0;
+
+	if(!(__atomic_load_n(&s->middle, __ATOMIC_ACQUIRE) & NEW_ROUND)) {
+		return 0;
+	}
+	old = __atomic_exchange_n(&s->middle, s->front, __ATOMIC_ACQ_REL);
+	s->front = old & ~NEW_ROUND;
+	slot = &s->slot[s->front];
+
+	if(renderer->direct) {
+		if(((screen->format->BytesPerPixel != 2) && (screen->format->BytesPerPixel != 4)) ||
+			(SDL_MUSTLOCK(screen) && (SDL_LockSurface(screen) < 0))) {
+			return 0;
+		}
+	}
+	else {
+		renderer->fill(NULL, 0x000000);
+	}
+	for(i=0; i<s->games; i++) {
+		if(renderer->direct && (s->drawn[i] == slot->versions[i])) {
+			continue;
+		}
+		x = s->left + (i % s->columns) * (s->w * s->scale + SPECTATOR_GAP);
+		y = s->top + (i / s->columns) * (s->h * s->scale + SPECTATOR_GAP);
+		if(renderer->direct) {
+			writeThumbnail(s, &slot->cells[i * cells], x, y);
+		}
+		else {
+			fillThumbnail(s, &slot->cells[i * cells], x, y);
+		}
+		s->drawn[i] = slot->versions[i];
+		drawn++;
+	}
+	if(renderer->direct && SDL_MUSTLOCK(screen)) {
+		SDL_UnlockSurface(screen);
+	}
+	return drawn;
+}
+
+/*!*****************************************************************************
+	\brief	Stop the games and free everything
+
+	\param	s
+		Spectator handler
+
+	\date	19.10.26
+*******************************************************************************/
+void stopSpectator(struct spectator *s) {
+	int i;
+
+	if(s->thread != NULL) {
+		__atomic_store_n(&s->quit, 1, __ATOMIC_RELAXED);
+		SDL_WaitThread(s->thread, NULL);
+	}
+	if(s->pool != NULL) {
+		destroyPool(s->pool);
+	}
+	for(i=0; (s->game != NULL) && (i<s->games); i++) {
+		freeBoard(&s->game[i].level.board);
+		freeDanger(&s->game[i].danger);
+		freeJournal(&s->game[i].journal);
+		freeExplosions(&s->game[i].explosions);
+	}
+	for(i=0; i<3; i++) {
+		free(s->slot[i].cells);
+		free(s->slot[i].versions);
+	}
+	free(s->game);
+	free(s->drawn);
+	memset(s, 0, sizeof(*s));
+}
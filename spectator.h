@@ -0,0 +1,78 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "sdl.h"
+#include "board.h"
+#include "level.h"
+#include "danger.h"
+#include "rules.h"
+#include "pool.h"
+
+#define SPECTATOR_MAX_GAMES 256
+#define SPECTATOR_GAP 2
+#define SPECTATOR_FPS 60
+
+/*!*****************************************************************************
+	\brief	One bot game played without a window
+
+	The version grows with every turn, so the mosaic can tell which games
+	have changed since it drew them. A game that is over is -1 if the hero
+	died and 1 if the level was cleared, and goes on on the next turn.
+
+	\date	19.10.26
+*******************************************************************************/
+struct spectatorGame {
+	struct level level;
+	struct journal journal;
+	struct dangerMap danger;
+	struct explosions explosions;
+	int heroX, heroY;
+	int teleports;
+	int killed;
+	int games;
+	int over;
+	unsigned long long state;
+	unsigned int version;
+};
+
+/*!*****************************************************************************
+	\brief	Cells of every game as they were after one round of turns
+
+	\date	19.10.26
+*******************************************************************************/
+struct mosaicSlot {
+	char *cells;
+	unsigned int *versions;
+};
+
+/*!*****************************************************************************
+	\brief	Many bot games played on a thread pool and shown as thumbnails
+
+	The games are played round after round as fast as the pool runs them,
+	and every round is published through a lock-free triple buffer like the
+	frames of the game, so the simulation never waits for the drawing.
+	Thumbnails are drawn one colour per cell, and only the games whose
+	version changed since they were last drawn are drawn again.
+
+	\date	19.10.26
+*******************************************************************************/
+struct spectator {
+	SDL_Thread *thread;
+	struct pool *pool;
+	int quit;
+	int games;
+	int w, h;
+	struct spectatorGame *game;
+	struct mosaicSlot slot[3];
+	int back, middle, front;
+	unsigned int *drawn;
+	int columns, scale;
+	int left, top;
+	Uint32 palette[256];
+};
+
+int startSpectator(struct spectator *s, int games, int w, int h, int windowW, int windowH, unsigned long long seed);
+int drawMosaic(struct spectator *s);
+void stopSpectator(struct spectator *s);
+
+#endif
@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "board.h"
+#include "pool.h"
+#include "rules.h"
+#include "stepper.h"
+
+/*
+	stepRobots first moves the robots from the hero on in reading order,
+	and then the ones before the hero backwards. Robots of the first sweep
+	always move to a cell earlier in reading order, and robots of the
+	second sweep to a later one, so no robot is ever hit before it has
+	moved. Within a sweep, what a cell ends up with then only depends on
+	what was there and how many robots arrive, never on their order. Each
+	sweep becomes one pass where every cell gathers from its neighbours,
+	and the tiles of a pass can be worked on in any order.
+*/
+
+/*!*****************************************************************************
+	\brief	Tell if a cell is moved in the first sweep of stepRobots
+
+	\date	19.10.26
+*******************************************************************************/
+static int firstSweep(const struct stepper *s, int x, int y) {
+	return (y > s->heroY) || ((y == s->heroY) && (x >= s->heroX));
+}
+
+/*!*****************************************************************************
+	\brief	Count the robots of one sweep moving into a cell
+
+	\param	s
+		Stepper handler
+
+	\param	b
+		Board as it was before the sweep
+
+	\param	x, y
+		Cell the robots move into
+
+	\param	first
+		1 for the first sweep, 0 for the second
+
+	\date	19.10.26
+*******************************************************************************/
+static int arrivals(const struct stepper *s, const struct board *b, int x, int y, int first) {
+	int dx, dy, sx, sy, count = 0;
+
+	for(dy=-1; dy<=1; dy++) {
+		for(dx=-1; dx<=1; dx++) {
+			sx = x + dx;
+			sy = y + dy;
+			if((sx < 0) || (sy < 0) || (sx >= b->w) || (sy >= b->h) || (CELL(b, sx, sy) != ROBOT) || (firstSweep(s, sx, sy) != first)) {
+				continue;
+			}
+			if((((sx < s->heroX)? sx+1: (sx > s->heroX)? sx-1: sx) == x) && (((sy < s->heroY)? sy+1: (sy > s->heroY)? sy-1: sy) == y)) {
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+/*!*****************************************************************************
+	\brief	Get what a cell holds after robots have moved into it
+
+	\param	base
+		Item in the cell once its own robot has left
+
+	\param	count
+		Robots moving in
+
+	\param	killed
+		Count of crashed robots to add to
+
+	\date	19.10.26
+*******************************************************************************/
+static char arrive(char base, int count, int *killed) {
+	if(!count) {
+		return base;
+	}
+	if(base == EMPTY) {
+		if(count == 1) {
+			return MOVED_ROBOT;
+		}
+		*killed += count;
+	}
+	else {
+		// The first robot on a robot that already moved crashes with it too
+		*killed += count + (base == MOVED_ROBOT);
+	}
+	return EXPLOSION;
+}
+
+/*!*****************************************************************************
+	\brief	First sweep of one tile, from the board to the scratch board
+
+	Also marks the chunks that have robots around them, only those can
+	change during the turn.
+
+	\param	data
+		Stepper handler
+
+	\param	tile
+		Row of chunks
+
+	\date	19.10.26
+*******************************************************************************/
+static void firstPass(void *data, int tile) {
+	struct stepper *s = (struct stepper *)data;
+	const struct board *b = s->board;
+	struct board *scratch = &s->scratch;
+	int top = tile << CHUNK_SHIFT, bottom = (top + CHUNK_SIZE < b->h)? top + CHUNK_SIZE: b->h;
+	int x, y, cx, cy, left, right, killed = 0;
+	unsigned char *active;
+	char own;
+
+	memcpy(&CELL(scratch, 0, top), &CELL(b, 0, top), (size_t)b->w * (bottom - top));
+	for(cx=0; cx<b->chunksX; cx++) {
+		active = &s->active[tile * b->chunksX + cx];
+		*active = 0;
+		for(cy=tile-1; cy<=tile+1; cy++) {
+			for(x=cx-1; x<=cx+1; x++) {
+				if((x >= 0) && (cy >= 0) && (x < b->chunksX) && (cy < b->chunksY) && CHUNK(b, x, cy)) {
+					*active = 1;
+				}
+			}
+		}
+		if(!*active) {
+			continue;
+		}
+		left = cx << CHUNK_SHIFT;
+		right = (left + CHUNK_SIZE < b->w)? left + CHUNK_SIZE: b->w;
+		for(y=top; y<bottom; y++) {
+			for(x=left; x<right; x++) {
+				own = CELL(b, x, y);
+				CELL(scratch, x, y) = arrive(((own == ROBOT) && firstSweep(s, x, y))? EMPTY: own, arrivals(s, b, x, y, 1), &killed);
+			}
+		}
+	}
+	s->logs[tile].killed = killed;
+}
+
+/*!*****************************************************************************
+	\brief	Second sweep of one tile, from the scratch board back to the board
+
+	Robots that moved become robots again, and every changed cell is logged
+	for the journal of the board.
+
+	\param	data
+		Stepper handler
+
+	\param	tile
+		Row of chunks
+
+	\date	19.10.26
+*******************************************************************************/
+static void secondPass(void *data, int tile) {
+	struct stepper *s = (struct stepper *)data;
+	struct board *b = s->board;
+	const struct board *scratch = &s->scratch;
+	struct tileLog *log = &s->logs[tile];
+	struct cellChange *grown;
+	int top = tile << CHUNK_SHIFT, bottom = (top + CHUNK_SIZE < b->h)? top + CHUNK_SIZE: b->h;
+	int x, y, cx, left, right, size;
+	char own, item, *cell;
+
+	log->count = 0;
+	for(cx=0; cx<b->chunksX; cx++) {
+		if(!s->active[tile * b->chunksX + cx]) {
+			continue;
+		}
+		left = cx << CHUNK_SHIFT;
+		right = (left + CHUNK_SIZE < b->w)? left + CHUNK_SIZE: b->w;
+		for(y=top; y<bottom; y++) {
+			for(x=left; x<right; x++) {
+				own = CELL(scratch, x, y);
+				item = arrive(((own == ROBOT) && !firstSweep(s, x, y))? EMPTY: own, arrivals(s, scratch, x, y, 0), &log->killed);
+				item = (item == MOVED_ROBOT)? ROBOT: item;
+				cell = &CELL(b, x, y);
+				if(item == *cell) {
+					continue;
+				}
+				if(log->count == log->size) {
+					size = log->size? log->size * 2: 256;
+					if((grown = realloc(log->changes, size * sizeof(*log->changes))) == NULL) {
+						log->failed = 1;
+					}
+					else {
+						log->changes = grown;
+						log->size = size;
+					}
+				}
+				if(log->count < log->size) {
+					log->changes[log->count].index = (int)(cell - b->cells);
+					log->changes[log->count].before = *cell;
+					log->count++;
+				}
+				CHUNK(b, cx, tile) += (item != 0) - (*cell != 0);
+				*cell = item;
+			}
+		}
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Get ready to move robots on a field size
+
+	Fields under STEPPER_MIN_CELLS cells get no threads.
+
+	\param	s
+		Stepper handler
+
+	\param	w, h
+		Size of the field
+
+	\return	0 on success, -1 if out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+int startStepper(struct stepper *s, int w, int h) {
+	memset(s, 0, sizeof(*s));
+	if(((long long)w * h < STEPPER_MIN_CELLS) || (cpuCount() < 2)) {
+		return 0;
+	}
+	if(createBoard(&s->scratch, w, h) ||
+		((s->active = malloc((size_t)s->scratch.chunksX * s->scratch.chunksY)) == NULL) ||
+		((s->logs = calloc(s->scratch.chunksY, sizeof(*s->logs))) == NULL) ||
+		((s->pool = createPool(cpuCount() - 1)) == NULL)) {
+		stopStepper(s);
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Move all robots one step towards the hero, on all cores
+
+	Gives the same board and the same count of crashed robots as
+	stepRobots. When a robot is next to the hero, the turn may end with
+	the hero caught half way through the robots, so it is moved by
+	stepRobots.
+
+	\param	s
+		Stepper handler
+
+	\param	b
+		Board to move the robots on
+
+	\param	heroX, heroY
+		Position of the hero
+
+	\param	killed
+		Count of crashed robots to add to
+
+	\return	1 if a robot caught the hero, 0 otherwise
+
+	\date	19.10.26
+*******************************************************************************/
+int stepTiles(struct stepper *s, struct board *b, int heroX, int heroY, int *killed) {
+	int x, y, tile, i, failed = 0;
+
+	if(s->pool == NULL) {
+		return stepRobots(b, heroX, heroY, killed);
+	}
+	for(y=heroY-1; y<=heroY+1; y++) {
+		for(x=heroX-1; x<=heroX+1; x++) {
+			if((x >= 0) && (y >= 0) && (x < b->w) && (y < b->h) && (CELL(b, x, y) == ROBOT)) {
+				return stepRobots(b, heroX, heroY, killed);
+			}
+		}
+	}
+	s->board = b;
+	s->heroX = heroX;
+	s->heroY = heroY;
+	runPool(s->pool, b->chunksY, firstPass, s);
+	runPool(s->pool, b->chunksY, secondPass, s);
+	for(tile=0; tile<b->chunksY; tile++) {
+		*killed += s->logs[tile].killed;
+		failed |= s->logs[tile].failed;
+		s->logs[tile].failed = 0;
+		for(i=0; (b->journal != NULL) && (i < s->logs[tile].count); i++) {
+			logChange(b->journal, s->logs[tile].changes[i].index, s->logs[tile].changes[i].before);
+		}
+	}
+	if(failed && (b->journal != NULL)) {
+		resetJournal(b->journal);
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Stop the threads and free the memory of a stepper
+
+	\param	s
+		Stepper handler
+
+	\date	19.10.26
+*******************************************************************************/
+void stopStepper(struct stepper *s) {
+	int tile;
+
+	if(s->pool != NULL) {
+		destroyPool(s->pool);
+	}
+	for(tile=0; (s->logs != NULL) && (tile < s->scratch.chunksY); tile++) {
+		free(s->logs[tile].changes);
+	}
+	free(s->logs);
+	free(s->active);
+	freeBoard(&s->scratch);
+	memset(s, 0, sizeof(*s));
+}
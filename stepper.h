@@ -0,0 +1,43 @@
+#ifndef STEPPER_H
+#define STEPPER_H
+
+#include "pool.h"
+#include "board.h"
+
+#define STEPPER_MIN_CELLS (256 * 256)
+
+/*!*****************************************************************************
+	\brief	Changes one tile made to the board during a turn
+
+	\date	19.10.26
+*******************************************************************************/
+struct tileLog {
+	struct cellChange *changes;
+	int count;
+	int size;
+	int killed;
+	int failed;
+};
+
+/*!*****************************************************************************
+	\brief	Robot mover splitting big boards in tiles run on a thread pool
+
+	A tile is one row of chunks. Small boards are moved on the calling
+	thread by stepRobots.
+
+	\date	19.10.26
+*******************************************************************************/
+struct stepper {
+	struct pool *pool;
+	struct board scratch;
+	unsigned char *active;
+	struct tileLog *logs;
+	struct board *board;
+	int heroX, heroY;
+};
+
+int startStepper(struct stepper *s, int w, int h);
+int stepTiles(struct stepper *s, struct board *b, int heroX, int heroY, int *killed);
+void stopStepper(struct stepper *s);
+
+#endif
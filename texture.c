@@ -0,0 +1,327 @@
+#ifdef USE_SDL2
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdl.h"
+#include "defs.h"
+#include "render.h"
+
+#define TEXT_CACHE	16
+#define TEXT_LENGTH	64
+
+enum {
+	DRAW_FILL=0,
+	DRAW_TINT,
+	DRAW_SPRITE,
+	DRAW_TEXT,
+};
+
+/*!*****************************************************************************
+	\brief	One queued drawing command, run when the frame is presented
+
+	\date	19.10.26
+*******************************************************************************/
+struct drawCommand {
+	int kind;
+	int sheet;
+	SDL_Texture *texture;
+	SDL_Rect src, dst;
+	int whole;
+	Uint32 colour;
+	int alpha;
+};
+
+/*!*****************************************************************************
+	\brief	Rendered text kept as a texture, the HUD seldom changes
+
+	\date	19.10.26
+*******************************************************************************/
+struct cachedText {
+	char text[TEXT_LENGTH];
+	Uint32 colour;
+	SDL_Texture *texture;
+	int w, h;
+};
+
+static SDL_Window *window;
+static SDL_Renderer *target;
+static SDL_Texture *sheet[SHEETS];
+static struct drawCommand *queue;
+static int queued, queueSize;
+static struct cachedText cache[TEXT_CACHE];
+static int nextCached;
+
+/*!*****************************************************************************
+	\brief	Open a window drawn with an SDL2 renderer
+
+	A hardware renderer with vsync is used when there is one, otherwise the
+	software renderer. screen only gives the size and pixel format of the
+	window, nothing is drawn on it.
+
+	\date	19.10.26
+*******************************************************************************/
+static int textureOpen(int w, int h, const char *caption) {
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1");
+	if((window = SDL_CreateWindow(caption, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, w, h, 0)) == NULL) {
+		return -1;
+	}
+	if(((target = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC)) == NULL) &&
+		((target = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE)) == NULL)) {
+		SDL_DestroyWindow(window);
+		window = NULL;
+		return -1;
+	}
+	if((screen = SDL_CreateRGBSurface(0, w, h, 32, 0xFF0000, 0xFF00, 0xFF, 0)) == NULL) {
+		SDL_DestroyRenderer(target);
+		SDL_DestroyWindow(window);
+		target = NULL;
+		window = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Upload the sprite sheets to textures
+
+	\date	19.10.26
+*******************************************************************************/
+static int textureLoad(SDL_Surface *const sheets[SHEETS]) {
+	int i;
+
+	for(i=0; i<SHEETS; i++) {
+		if((sheet[i] = SDL_CreateTextureFromSurface(target, sheets[i])) == NULL) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Get room for one more command in the queue
+
+	\return	Command to fill in, or NULL when out of memory
+
+	\date	19.10.26
+*******************************************************************************/
+static struct drawCommand *queueCommand(int kind) {
+	struct drawCommand *grown;
+	int size;
+
+	if(queued == queueSize) {
+		size = queueSize? queueSize * 2: 1024;
+		if((grown = realloc(queue, size * sizeof(*queue))) == NULL) {
+			return NULL;
+		}
+		queue = grown;
+		queueSize = size;
+	}
+	memset(&queue[queued], 0, sizeof(*queue));
+	queue[queued].kind = kind;
+	return &queue[queued++];
+}
+
+/*!*****************************************************************************
+	\brief	Queue filling an area, all of the window if rect is NULL
+
+	\date	19.10.26
+*******************************************************************************/
+static void textureFill(SDL_Rect *rect, Uint32 colour) {
+	struct drawCommand *command;
+
+	if((command = queueCommand(DRAW_FILL)) != NULL) {
+		command->whole = (rect == NULL);
+		if(rect != NULL) {
+			command->dst = *rect;
+		}
+		command->colour = colour;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Queue blending a colour over an area
+
+	\date	19.10.26
+*******************************************************************************/
+static void textureTint(SDL_Rect *rect, Uint32 colour, int alpha) {
+	struct drawCommand *command;
+
+	if((command = queueCommand(DRAW_TINT)) != NULL) {
+		command->dst = *rect;
+		command->colour = colour;
+		command->alpha = alpha;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Queue a sprite, scaled to the size of dst
+
+	\date	19.10.26
+*******************************************************************************/
+static void textureSprite(int index, SDL_Rect *src, SDL_Rect *dst) {
+	struct drawCommand *command;
+
+	if((command = queueCommand(DRAW_SPRITE)) != NULL) {
+		command->sheet = index;
+		command->src = *src;
+		command->dst = *dst;
+	}
+}
+
+/*!*****************************************************************************
+	\brief	Get a text as a texture, rendering it only if it is not cached
+
+	\date	19.10.26
+*******************************************************************************/
+static struct cachedText *cachedText(const char *text, Uint32 colour) {
+	SDL_Color color = {(colour & 0xFF0000) >> 16, (colour & 0xFF00) >> 8, (colour & 0xFF)};
+	struct cachedText *entry;
+	SDL_Surface *rendText;
+	int i;
+
+	for(i=0; i<TEXT_CACHE; i++) {
+		if((cache[i].texture != NULL) && (cache[i].colour == colour) && !strcmp(cache[i].text, text)) {
+			return &cache[i];
+		}
+	}
+	if((strlen(text) >= TEXT_LENGTH) || ((rendText = TTF_RenderText_Solid(font, text, color)) == NULL)) {
+		return NULL;
+	}
+	entry = &cache[nextCached];
+	nextCached = (nextCached + 1) % TEXT_CACHE;
+	if(entry->texture != NULL) {
+		SDL_DestroyTexture(entry->texture);
+	}
+	entry->texture = SDL_CreateTextureFromSurface(target, rendText);
+	entry->w = rendText->w;
+	entry->h = rendText->h;
+	entry->colour = colour;
+	strcpy(entry->text, text);
+	SDL_FreeSurface(rendText);
+	return (entry->texture != NULL)? entry: NULL;
+}
+
+/*!*****************************************************************************
+	\brief	Queue a text
+
+	\date	19.10.26
+*******************************************************************************/
+static int textureText(int x, int y, int w, const char *text, Uint32 colour) {
+	struct drawCommand *command;
+	struct cachedText *entry;
+
+	if((font == NULL) || (text == NULL) || ((entry = cachedText(text, colour)) == NULL)) {
+		return -1;
+	}
+	if((command = queueCommand(DRAW_TEXT)) == NULL) {
+		return -1;
+	}
+	command->texture = entry->texture;
+	initRectangle(&command->src, 0, 0, ((!w)? entry->w: w), entry->h);
+	placeText(&command->dst, x, y, w, entry->w, entry->h);
+	return 0;
+}
+
+/*!*****************************************************************************
+	\brief	Draw the queued commands and show the frame
+
+	Sprites queued one after another are cells of the field and never
+	overlap, so they are drawn sheet by sheet. That way the renderer can
+	batch all sprites of a sheet into one draw call.
+
+	\date	19.10.26
+*******************************************************************************/
+static void texturePresent(void) {
+	struct drawCommand *command;
+	int i, end, index;
+
+	for(i=0; i<queued; i=end) {
+		command = &queue[i];
+		end = i + 1;
+		switch(command->kind) {
+			case DRAW_FILL:
+				SDL_SetRenderDrawColor(target, (command->colour >> 16) & 0xFF, (command->colour >> 8) & 0xFF, command->colour & 0xFF, 0xFF);
+				if(command->whole) {
+					SDL_RenderClear(target);
+				}
+				else {
+					SDL_RenderFillRect(target, &command->dst);
+				}
+			break;
+			case DRAW_TINT:
+				SDL_SetRenderDrawBlendMode(target, SDL_BLENDMODE_BLEND);
+				SDL_SetRenderDrawColor(target, (command->colour >> 16) & 0xFF, (command->colour >> 8) & 0xFF, command->colour & 0xFF, command->alpha);
+				SDL_RenderFillRect(target, &command->dst);
+				SDL_SetRenderDrawBlendMode(target, SDL_BLENDMODE_NONE);
+			break;
+			case DRAW_SPRITE:
+				while((end < queued) && (queue[end].kind == DRAW_SPRITE)) {
+					end++;
+				}
+				for(index=0; index<SHEETS; index++) {
+					for(command=&queue[i]; command<&queue[end]; command++) {
+						if(command->sheet == index) {
+							SDL_RenderCopy(target, sheet[index], &command->src, &command->dst);
+						}
+					}
+				}
+			break;
+			case DRAW_TEXT:
+				SDL_RenderCopy(target, command->texture, &command->src, &command->dst);
+			break;
+		}
+	}
+	queued = 0;
+	SDL_RenderPresent(target);
+}
+
+/*!*****************************************************************************
+	\brief	Free the textures and close the window
+
+	\date	19.10.26
+*******************************************************************************/
+static void textureClose(void) {
+	int i;
+
+	for(i=0; i<TEXT_CACHE; i++) {
+		if(cache[i].texture != NULL) {
+			SDL_DestroyTexture(cache[i].texture);
+		}
+		cache[i].texture = NULL;
+	}
+	for(i=0; i<SHEETS; i++) {
+		if(sheet[i] != NULL) {
+			SDL_DestroyTexture(sheet[i]);
+		}
+		sheet[i] = NULL;
+	}
+	if(target != NULL) {
+		SDL_DestroyRenderer(target);
+	}
+	if(window != NULL) {
+		SDL_DestroyWindow(window);
+	}
+	SDL_FreeSurface(screen);
+	free(queue);
+	queue = NULL;
+	queued = queueSize = 0;
+	target = NULL;
+	window = NULL;
+	screen = NULL;
+}
+
+const struct renderer textureRenderer = {
+	"texture",
+	0,
+	1,
+	textureOpen,
+	textureLoad,
+	textureFill,
+	textureTint,
+	textureSprite,
+	textureText,
+	texturePresent,
+	textureClose,
+};
+#endif